@@ -90,6 +90,48 @@ namespace ibpp_internals
 		}
 		return a;
 	}
+
+	ThreadCheck::ThreadCheck(DatabaseImpl* database)
+	{
+		if (database != 0) Enter(database);
+	}
+
+	ThreadCheck::ThreadCheck(const std::vector<DatabaseImpl*>& databases)
+	{
+		// All or none : those entered are left when one of them is busy
+		try
+		{
+			for (unsigned i = 0; i < databases.size(); i++)
+				Enter(databases[i]);
+		}
+		catch (...) { Leave(); throw; }
+	}
+
+	ThreadCheck::~ThreadCheck()
+	{
+		Leave();
+	}
+
+	void ThreadCheck::Enter(DatabaseImpl* database)
+	{
+		std::thread::id user;
+		const std::thread::id self = std::this_thread::get_id();
+		if (! database->mThreadUser.compare_exchange_strong(user, self))
+			ASSERTION(user == self);	// Else another thread is using it
+		++database->mThreadDepth;
+		mDatabases.push_back(database);
+	}
+
+	void ThreadCheck::Leave()
+	{
+		while (! mDatabases.empty())
+		{
+			DatabaseImpl* database = mDatabases.back();
+			mDatabases.pop_back();
+			if (--database->mThreadDepth == 0)
+				database->mThreadUser.store(std::thread::id());
+		}
+	}
 #endif	// _DEBUG
 
 }
@@ -99,182 +141,183 @@ using namespace ibpp_internals;
 GDS* GDS::Call()
 {
 	// Let's load the CLIENT library, if it is not already loaded.
-	// The load is guaranteed to be done only once per application.
+	// The load is guaranteed to be done only once per application, even when
+	// several threads get here at the same time : the others wait for it.
+	// Should the load throw, the next call will attempt it again.
 
-	if (! mReady)
-	{
+	std::call_once(mReady, &GDS::Load, this);
+	return mTable.load(std::memory_order_acquire);
+}
+
+void GDS::Load()
+{
 #ifdef IBPP_WINDOWS
 
-		// Let's load the FBCLIENT.DLL or GDS32.DLL, we will never release it.
-		// Windows will do that for us when the executable will terminate.
+	// Let's load the FBCLIENT.DLL or GDS32.DLL, we will never release it.
+	// Windows will do that for us when the executable will terminate.
 
-		char fbdll[MAX_PATH];
-		HKEY hkey_instances;
+	char fbdll[MAX_PATH];
+	HKEY hkey_instances;
 
-		// Try to load FBCLIENT.DLL from each of the additional optional paths
-		// that may have been specified through ClientLibSearchPaths().
-		// We also want to actually update the environment PATH so that it references
-		// the specific path from where we attempt the load. This is useful because
-		// it directs the system to attempt finding dependencies (like the C/C++
-		// runtime libraries) from the same location where FBCLIENT is found.
+	// Try to load FBCLIENT.DLL from each of the additional optional paths
+	// that may have been specified through ClientLibSearchPaths().
+	// We also want to actually update the environment PATH so that it references
+	// the specific path from where we attempt the load. This is useful because
+	// it directs the system to attempt finding dependencies (like the C/C++
+	// runtime libraries) from the same location where FBCLIENT is found.
 
-		mHandle = 0;
+	mHandle = 0;
 
-		std::string SysPath(getenv("PATH"));
-		std::string::size_type pos = 0;
-		while (pos < mSearchPaths.size())
-		{
-			std::string::size_type newpos = mSearchPaths.find(';', pos);
+	std::string SysPath(getenv("PATH"));
+	std::string::size_type pos = 0;
+	while (pos < mSearchPaths.size())
+	{
+		std::string::size_type newpos = mSearchPaths.find(';', pos);
 
-			std::string path;
-			if (newpos == std::string::npos) path = mSearchPaths.substr(pos);
-			else path = mSearchPaths.substr(pos, newpos-pos);
+		std::string path;
+		if (newpos == std::string::npos) path = mSearchPaths.substr(pos);
+		else path = mSearchPaths.substr(pos, newpos-pos);
 
-			if (path.size() >= 1)
-			{
-				if (path[path.size()-1] != '\\') path += '\\';
+		if (path.size() >= 1)
+		{
+			if (path[path.size()-1] != '\\') path += '\\';
 
-				AppPath.assign("PATH=");
-				AppPath.append(path).append(";").append(SysPath);
-				putenv(AppPath.c_str());
+			AppPath.assign("PATH=");
+			AppPath.append(path).append(";").append(SysPath);
+			putenv(AppPath.c_str());
 
-				path.append("fbclient.dll");
-				mHandle = LoadLibrary(path.c_str());
-				if (mHandle != 0 || newpos == std::string::npos) break;
-			}
-			pos = newpos + 1;
+			path.append("fbclient.dll");
+			mHandle = LoadLibrary(path.c_str());
+			if (mHandle != 0 || newpos == std::string::npos) break;
 		}
+		pos = newpos + 1;
+	}
 
-		if (mHandle == 0)
-		{
-			// Try to load FBCLIENT.DLL from the current application location.  This
-			// is a usefull step for applications using the embedded version of FB
-			// or a local copy (for whatever reasons) of the dll.
+	if (mHandle == 0)
+	{
+		// Try to load FBCLIENT.DLL from the current application location.  This
+		// is a usefull step for applications using the embedded version of FB
+		// or a local copy (for whatever reasons) of the dll.
 
-			if (! AppPath.empty())
-			{
-				// Restores the original system path
-				AppPath.assign("PATH=");
-				AppPath.append(SysPath);
-				putenv(AppPath.c_str());
-			}
+		if (! AppPath.empty())
+		{
+			// Restores the original system path
+			AppPath.assign("PATH=");
+			AppPath.append(SysPath);
+			putenv(AppPath.c_str());
+		}
 
-			int len = GetModuleFileName(NULL, fbdll, sizeof(fbdll));
-			if (len != 0)
+		int len = GetModuleFileName(NULL, fbdll, sizeof(fbdll));
+		if (len != 0)
+		{
+			// Get to the last '\' (this one precedes the filename part).
+			// There is always one after a success call to GetModuleFileName().
+			char* p = fbdll + len;
+			do {--p;} while (*p != '\\');
+			*p = '\0';
+			lstrcat(fbdll, "\\fbembed.dll");// Local copy could be named fbembed.dll
+			mHandle = LoadLibrary(fbdll);
+			if (mHandle == 0)
 			{
-				// Get to the last '\' (this one precedes the filename part).
-				// There is always one after a success call to GetModuleFileName().
-				char* p = fbdll + len;
-				do {--p;} while (*p != '\\');
 				*p = '\0';
-				lstrcat(fbdll, "\\fbembed.dll");// Local copy could be named fbembed.dll
+				lstrcat(fbdll, "\\fbclient.dll");	// Or possibly renamed fbclient.dll
 				mHandle = LoadLibrary(fbdll);
-				if (mHandle == 0)
-				{
-					*p = '\0';
-					lstrcat(fbdll, "\\fbclient.dll");	// Or possibly renamed fbclient.dll
-					mHandle = LoadLibrary(fbdll);
-				}
 			}
 		}
+	}
 
-		if (mHandle == 0)
-		{
-			// Try to locate FBCLIENT.DLL through the optional FB registry key.
+	if (mHandle == 0)
+	{
+		// Try to locate FBCLIENT.DLL through the optional FB registry key.
 
-			if (RegOpenKeyEx(HKEY_LOCAL_MACHINE, REG_KEY_ROOT_INSTANCES, 0,
-				KEY_READ, &hkey_instances) == ERROR_SUCCESS)
+		if (RegOpenKeyEx(HKEY_LOCAL_MACHINE, REG_KEY_ROOT_INSTANCES, 0,
+			KEY_READ, &hkey_instances) == ERROR_SUCCESS)
+		{
+			DWORD keytype;
+			DWORD buflen = sizeof(fbdll);
+			if (RegQueryValueEx(hkey_instances, FB_DEFAULT_INSTANCE, 0,
+					&keytype, reinterpret_cast<UCHAR*>(fbdll),
+						&buflen) == ERROR_SUCCESS && keytype == REG_SZ)
 			{
-				DWORD keytype;
-				DWORD buflen = sizeof(fbdll);
-				if (RegQueryValueEx(hkey_instances, FB_DEFAULT_INSTANCE, 0,
-						&keytype, reinterpret_cast<UCHAR*>(fbdll),
-							&buflen) == ERROR_SUCCESS && keytype == REG_SZ)
-				{
-					lstrcat(fbdll, "bin\\fbclient.dll");
-					mHandle = LoadLibrary(fbdll);
-				}
-				RegCloseKey(hkey_instances);
+				lstrcat(fbdll, "bin\\fbclient.dll");
+				mHandle = LoadLibrary(fbdll);
 			}
+			RegCloseKey(hkey_instances);
 		}
+	}
 
+	if (mHandle == 0)
+	{
+		// Let's try from the PATH and System directories
+		mHandle = LoadLibrary("fbclient.dll");
 		if (mHandle == 0)
 		{
-			// Let's try from the PATH and System directories
-			mHandle = LoadLibrary("fbclient.dll");
+			// Not found. Last try : attemps loading gds32.dll from PATH and
+			// System directories
+			mHandle = LoadLibrary("gds32.dll");
 			if (mHandle == 0)
-			{
-				// Not found. Last try : attemps loading gds32.dll from PATH and
-				// System directories
-				mHandle = LoadLibrary("gds32.dll");
-				if (mHandle == 0)
-					throw LogicExceptionImpl("GDS::Call()",
-						_("Can't find or load FBCLIENT.DLL or GDS32.DLL"));
-			}
+				throw LogicExceptionImpl("GDS::Call()",
+					_("Can't find or load FBCLIENT.DLL or GDS32.DLL"));
 		}
+	}
 #endif
 
-		mGDSVersion = 60;
+	mGDSVersion = 60;
 
-		// Get the entry points that we need
+	// Get the entry points that we need
 
 #ifdef IBPP_WINDOWS
 #define IB_ENTRYPOINT(X) \
-			if ((m_##X = (proto_##X*)GetProcAddress(mHandle, "isc_"#X)) == 0) \
-				throw LogicExceptionImpl("GDS:gds()", _("Entry-point isc_"#X" not found"))
+		if ((m_##X = (proto_##X*)GetProcAddress(mHandle, "isc_"#X)) == 0) \
+			throw LogicExceptionImpl("GDS:gds()", _("Entry-point isc_"#X" not found"))
 #endif
 #ifdef IBPP_UNIX
 /* TODO : perform a late-bind on unix --- not so important, well I think (OM) */
 #define IB_ENTRYPOINT(X) m_##X = (proto_##X*)isc_##X
 #endif
 
-		IB_ENTRYPOINT(create_database);
-		IB_ENTRYPOINT(attach_database);
-		IB_ENTRYPOINT(detach_database);
-		IB_ENTRYPOINT(drop_database);
-		IB_ENTRYPOINT(database_info);
-		IB_ENTRYPOINT(open_blob2);
-		IB_ENTRYPOINT(create_blob2);
-		IB_ENTRYPOINT(close_blob);
-		IB_ENTRYPOINT(cancel_blob);
-		IB_ENTRYPOINT(get_segment);
-		IB_ENTRYPOINT(put_segment);
-		IB_ENTRYPOINT(blob_info);
-		IB_ENTRYPOINT(array_lookup_bounds);
-		IB_ENTRYPOINT(array_get_slice);
-		IB_ENTRYPOINT(array_put_slice);
-		IB_ENTRYPOINT(vax_integer);
-		IB_ENTRYPOINT(sqlcode);
-		IB_ENTRYPOINT(sql_interprete);
-		IB_ENTRYPOINT(interprete);
-		IB_ENTRYPOINT(que_events);
-		IB_ENTRYPOINT(cancel_events);
-		IB_ENTRYPOINT(start_multiple);
-		IB_ENTRYPOINT(commit_transaction);
-		IB_ENTRYPOINT(commit_retaining);
-		IB_ENTRYPOINT(rollback_transaction);
-		IB_ENTRYPOINT(rollback_retaining);
-		IB_ENTRYPOINT(dsql_execute_immediate);
-		IB_ENTRYPOINT(dsql_allocate_statement);
-		IB_ENTRYPOINT(dsql_describe);
-		IB_ENTRYPOINT(dsql_describe_bind);
-		IB_ENTRYPOINT(dsql_prepare);
-		IB_ENTRYPOINT(dsql_execute);
-		IB_ENTRYPOINT(dsql_execute2);
-		IB_ENTRYPOINT(dsql_fetch);
-		IB_ENTRYPOINT(dsql_free_statement);
-		IB_ENTRYPOINT(dsql_set_cursor_name);
-		IB_ENTRYPOINT(dsql_sql_info);
-
-		IB_ENTRYPOINT(service_attach);
-		IB_ENTRYPOINT(service_detach);
-		IB_ENTRYPOINT(service_start);
-		IB_ENTRYPOINT(service_query);
-
-		mReady = true;
-	}
-
-	return this;
+	IB_ENTRYPOINT(create_database);
+	IB_ENTRYPOINT(attach_database);
+	IB_ENTRYPOINT(detach_database);
+	IB_ENTRYPOINT(drop_database);
+	IB_ENTRYPOINT(database_info);
+	IB_ENTRYPOINT(open_blob2);
+	IB_ENTRYPOINT(create_blob2);
+	IB_ENTRYPOINT(close_blob);
+	IB_ENTRYPOINT(cancel_blob);
+	IB_ENTRYPOINT(get_segment);
+	IB_ENTRYPOINT(put_segment);
+	IB_ENTRYPOINT(blob_info);
+	IB_ENTRYPOINT(array_lookup_bounds);
+	IB_ENTRYPOINT(array_get_slice);
+	IB_ENTRYPOINT(array_put_slice);
+	IB_ENTRYPOINT(vax_integer);
+	IB_ENTRYPOINT(sqlcode);
+	IB_ENTRYPOINT(sql_interprete);
+	IB_ENTRYPOINT(interprete);
+	IB_ENTRYPOINT(que_events);
+	IB_ENTRYPOINT(cancel_events);
+	IB_ENTRYPOINT(start_multiple);
+	IB_ENTRYPOINT(commit_transaction);
+	IB_ENTRYPOINT(commit_retaining);
+	IB_ENTRYPOINT(rollback_transaction);
+	IB_ENTRYPOINT(rollback_retaining);
+	IB_ENTRYPOINT(dsql_execute_immediate);
+	IB_ENTRYPOINT(dsql_allocate_statement);
+	IB_ENTRYPOINT(dsql_describe);
+	IB_ENTRYPOINT(dsql_describe_bind);
+	IB_ENTRYPOINT(dsql_prepare);
+	IB_ENTRYPOINT(dsql_execute);
+	IB_ENTRYPOINT(dsql_execute2);
+	IB_ENTRYPOINT(dsql_fetch);
+	IB_ENTRYPOINT(dsql_free_statement);
+	IB_ENTRYPOINT(dsql_set_cursor_name);
+	IB_ENTRYPOINT(dsql_sql_info);
+
+	IB_ENTRYPOINT(service_attach);
+	IB_ENTRYPOINT(service_detach);
+	IB_ENTRYPOINT(service_start);
+	IB_ENTRYPOINT(service_query);
 }
 
 namespace IBPP
@@ -323,11 +366,11 @@ namespace IBPP
 	}
 
 	Transaction TransactionFactory(Database db, TAM am,
-					TIL il, TLR lr, TFF flags)
+					TIL il, TLR lr, TFF flags, int LockTimeout)
 	{
 		(void)gds.Call();			// Triggers the initialization, if needed
 		return new TransactionImpl(	dynamic_cast<DatabaseImpl*>(db.intf()),
-									am, il, lr, flags);
+									am, il, lr, flags, LockTimeout);
 	}
 
 	Statement StatementFactory(Database db, Transaction tr,
@@ -359,6 +402,38 @@ namespace IBPP
 		return new EventsImpl(dynamic_cast<DatabaseImpl*>(db.intf()));
 	}
 
+	DatabasePool DatabasePoolFactory(const std::string& ServerName,
+		const std::string& DatabaseName, const std::string& UserName,
+		const std::string& UserPassword, const std::string& RoleName,
+		const std::string& CharSet, int MinSize, int MaxSize, int IdleSeconds,
+		const std::vector<std::string>& WarmSql)
+	{
+		(void)gds.Call();			// Triggers the initialization, if needed
+		return new DatabasePoolImpl(ServerName, DatabaseName, UserName,
+			UserPassword, RoleName, CharSet, MinSize, MaxSize, IdleSeconds, WarmSql);
+	}
+
+	Executor ExecutorFactory(Database db)
+	{
+		(void)gds.Call();			// Triggers the initialization, if needed
+		return new ExecutorImpl(dynamic_cast<DatabaseImpl*>(db.intf()));
+	}
+
+	ParallelScan ParallelScanFactory(Database db, const std::string& sql,
+		const std::string& key, int parts, PSO order)
+	{
+		(void)gds.Call();			// Triggers the initialization, if needed
+		return new ParallelScanImpl(db, sql, key, parts, order);
+	}
+
+	BulkLoader BulkLoaderFactory(Database db, const std::string& sql,
+		int parts, int commitRows, int commitMs, int64_t memoryBudget)
+	{
+		(void)gds.Call();			// Triggers the initialization, if needed
+		return new BulkLoaderImpl(db, sql, parts, commitRows, commitMs,
+			memoryBudget);
+	}
+
 }
 
 //
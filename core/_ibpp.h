@@ -62,6 +62,16 @@
 #include <limits>
 #include <string>
 #include <vector>
+#include <list>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <thread>
 #include <sstream>
 #include <cstdarg>
 
@@ -117,6 +127,7 @@ class StatementImpl;
 class BlobImpl;
 class ArrayImpl;
 class EventsImpl;
+class RowImpl;
 
 //	Native data types
 typedef enum {ivArray, ivBlob, ivDate, ivTime, ivTimestamp, ivString,
@@ -391,7 +402,8 @@ typedef void        ISC_EXPORT proto_encode_timestamp (void *,
 struct GDS
 {
 	// Attributes
-	bool mReady;
+	std::once_flag mReady;	// The entry points get loaded only once
+	std::atomic<GDS*> mTable;	// Entry points Call() returns, see _trace.cpp
 	int mGDSVersion; 		// Version of the GDS32.DLL (50 for 5.0, 60 for 6.0)
 
 #ifdef IBPP_WINDOWS
@@ -400,6 +412,7 @@ struct GDS
 #endif
 
 	GDS* Call();
+	void Load();
 
 	// GDS32 Entry Points
 	proto_create_database*			m_create_database;
@@ -458,9 +471,8 @@ struct GDS
 	//proto_encode_timestamp*			m_encode_timestamp;
 
 	// Constructor (No need for a specific destructor)
-	GDS()
+	GDS() : mTable(this)
 	{
-		mReady = false;
 		mGDSVersion = 0;
 #ifdef IBPP_WINDOWS
 		mHandle = 0;
@@ -542,6 +554,7 @@ class TPB
 public:
 	void Insert(char);				// Insert a flag item
 	void Insert(const std::string& data); // Insert a string (typically table name)
+	void Insert(char, int32_t);		// Insert an item and its 4 bytes value
 	void Reset();				// Clears the TPB
 	char* Self() { return mBuffer; }
 	int Size() { return mSize; }
@@ -600,6 +613,230 @@ public:
 	~IBS();
 };
 
+//
+//	Reference counter of the implementation objects. Smart pointers to the
+//	same object may be copied and dropped from different threads : increments
+//	are relaxed, decrements are acq_rel so that the thread which drops the
+//	last reference sees every write made through the other ones.
+//
+
+class RefCount
+{
+	std::atomic<int> mCount;
+
+	RefCount(const RefCount&);
+	RefCount& operator=(const RefCount&);
+
+public:
+	void operator++() { mCount.fetch_add(1, std::memory_order_relaxed); }
+	int operator--() { return mCount.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+	operator int() const { return mCount.load(std::memory_order_relaxed); }
+
+	explicit RefCount(int count) : mCount(count) { }
+};
+
+//
+//	Debug builds check the threading contract of ibpp.h : a Database and the
+//	objects attached to it are used by one thread at a time. The public calls
+//	which reach the server hold a ThreadCheck of their attachment (all of
+//	them for a Transaction), which
+//	asserts that no other thread is inside such a call. Nested calls of the
+//	same thread are fine, and the attachment may move to another thread
+//	between calls (DatabasePool, Executor).
+//
+
+#ifdef _DEBUG
+class ThreadCheck
+{
+	std::vector<DatabaseImpl*> mDatabases;	// Those entered
+
+	ThreadCheck(const ThreadCheck&);
+	ThreadCheck& operator=(const ThreadCheck&);
+	void Enter(DatabaseImpl*);
+	void Leave();
+
+public:
+	explicit ThreadCheck(DatabaseImpl* database);
+	explicit ThreadCheck(const std::vector<DatabaseImpl*>& databases);	// Transaction
+	~ThreadCheck();
+};
+#define THREADCHECK(databases)	ThreadCheck threadCheck(databases)
+#else
+#define THREADCHECK(databases)	/* databases */
+#endif
+
+//
+//	Used to recycle the rows handed out by Statement::Fetch(Row&).
+//	A statement owns one pool per prepared shape. Rows it hands out keep the
+//	pool alive and go back to it when released, until the statement closes
+//	the pool (Drain) because it prepares something else or goes away.
+//	Rows may be released from any thread, hence the lock.
+//
+
+class RowPool
+{
+	static const int MAXIDLE;
+
+	RefCount mRefCount;				// The statement + rows handed out
+	std::mutex mLock;				// Guards mOpen and mIdle
+	bool mOpen;						// False once drained
+	std::vector<RowImpl*> mIdle;	// Released rows, ready for re-use
+
+public:
+	RowImpl* Take(const RowImpl& shape);	// Idle row or copy of shape
+	bool Recycle(RowImpl*);			// Keeps a released row, if possible
+	void Drain();					// Frees idle rows, stops recycling
+	void AddRef() { ++mRefCount; }
+	void Release();
+
+	RowPool() : mRefCount(1), mOpen(true) { }
+	~RowPool();
+};
+
+//
+//	Fetches a result set ahead of the consumer, from a thread of its own, into
+//	a ring of rows taken from the statement's RowPool (see Statement::Prefetch).
+//	The consumer Pop()s the rows, then releases them back to the pool.
+//
+
+class Prefetcher
+{
+	static const int GROWMAX;		// Rows a pfGrow ring grows up to
+
+	isc_stmt_handle* mHandle;		// The statement's handle, open cursor
+	RowImpl* mShape;				// Own copy of the statement's output row
+	RowPool* mPool;
+	int mRingSize;
+	IBPP::PFP mPolicy;
+
+	std::mutex mLock;					// Guards the members below
+	std::condition_variable mFilled;	// A row is ready, or the end reached
+	std::condition_variable mEmptied;	// A row was taken, or stopping
+	std::deque<RowImpl*> mReady;		// Fetched rows, oldest first
+	bool mEnd;							// No more rows will come
+	bool mStopping;
+	IBS* mError;						// Status of a failed fetch
+	std::exception_ptr mFailure;		// Anything else thrown by the thread
+	int mRows;
+	int mStalls;
+	int mWaits;
+	std::thread mThread;				// Started last, once all is ready
+
+	void Loop();
+	static void Discard(RowImpl*);
+
+public:
+	RowImpl* Pop(IBS*& error, std::exception_ptr& failure);	// 0 at the end or on error
+	void Stop();					// Ends the thread, drops unread rows
+	void Statistics(int* Rows, int* Stalls, int* Waits);
+
+	Prefetcher(isc_stmt_handle*, const RowImpl& shape, RowPool*,
+		int size, IBPP::PFP policy);
+	~Prefetcher();
+};
+
+//
+//	Latency histogram of IBPP::QueryStats, in the way of HdrHistogram : the
+//	nanoseconds are counted in buckets of an eighth of a power of two (one per
+//	nanosecond below 16), so that any value is known within 12.5%. Up to
+//	2^44 ns (about 5 hours), beyond that in the last bucket. Lock-free.
+//
+
+class LatencyHistogram
+{
+	enum {LINEAR = 16, SUBS = 8, BUCKETS = LINEAR + 40 * SUBS};
+
+	std::atomic<int64_t> mCounts[BUCKETS];
+	std::atomic<int64_t> mTotal;		// Nanoseconds, for the mean
+	std::atomic<int64_t> mMax;
+
+	static int Bucket(int64_t ns);
+	static int64_t Highest(int bucket);	// Largest value counted in it
+
+public:
+	void Record(int64_t ns);
+	void Summary(IBPP::LatencySummary&) const;
+	void Reset();
+
+	LatencyHistogram() { Reset(); }
+};
+
+//
+//	Statistics of all the statements sharing one SQL fingerprint, created by
+//	Find() on first use and never freed : the statements keep a pointer to
+//	the profile of their SQL (see StatementImpl::Profile()).
+//
+
+class QueryProfile
+{
+public:
+	const std::string mFingerprint;
+	const uint64_t mHash;
+	LatencyHistogram mPrepare;
+	LatencyHistogram mExecute;
+	LatencyHistogram mFetch;			// One Fetch() or FetchBatch()
+	std::atomic<int64_t> mRowsFetched;
+	std::atomic<int64_t> mRowsAffected;
+
+	static std::atomic<bool> mEnabled;	// See IBPP::EnableQueryStats()
+
+	static QueryProfile* Find(const std::string& sql);
+	static std::string Fingerprint(const std::string& sql);
+	static uint64_t Hash(const std::string&);
+
+	QueryProfile(const std::string& fingerprint);
+};
+
+//	Adds the time from its construction to Stop() or its destruction to one
+//	histogram of a profile, if any.
+
+class QueryTimer
+{
+	LatencyHistogram* mHistogram;
+	std::chrono::steady_clock::time_point mStart;
+
+public:
+	void Stop()
+	{
+		if (mHistogram == 0) return;
+		mHistogram->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - mStart).count());
+		mHistogram = 0;
+	}
+
+	QueryTimer(QueryProfile* profile, LatencyHistogram QueryProfile::* histogram)
+		: mHistogram(profile == 0 ? 0 : &(profile->*histogram))
+	{
+		if (mHistogram != 0) mStart = std::chrono::steady_clock::now();
+	}
+	~QueryTimer() { Stop(); }
+};
+
+//
+//	Measures, when enabled, the work between Begin() and End() as the
+//	difference of two IBPP::PerfStats taken on the given attachments (see
+//	Statement::SetPerfStats() and Transaction::SetPerfStats()).
+//
+
+class PerfProbe
+{
+	bool mOn;
+	bool mOpen;					// Begun, not yet ended
+	IBPP::PerfStats mStart;
+	IBPP::PerfStats mLast;		// Last measure ended
+
+	static void Take(DatabaseImpl* const* databases, size_t count,
+		IBPP::PerfStats&);
+
+public:
+	void Enable(bool on) { mOn = on; mOpen = false; }
+	void Begin(DatabaseImpl* const* databases, size_t count);
+	void End(DatabaseImpl* const* databases, size_t count);	// Never throws
+	void Last(IBPP::PerfStats& stats) { stats = mLast; }
+
+	PerfProbe() : mOn(false), mOpen(false) { }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //	Implementation of the "hidden" classes associated with their public
@@ -753,7 +990,7 @@ class ServiceImpl : public IBPP::IService
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
-	int mRefCount;				// Reference counter
+	RefCount mRefCount;			// Reference counter
     isc_svc_handle mHandle;		// InterBase API Service Handle
 	std::string mServerName;	// Nom du serveur
     std::string mUserName;		// Nom de l'utilisateur
@@ -814,7 +1051,7 @@ class DatabaseImpl : public IBPP::IDatabase
 {
 	//	(((((((( OBJECT INTERNALS ))))))))
 
-	int mRefCount;				// Reference counter
+	RefCount mRefCount;			// Reference counter
     isc_db_handle mHandle;		// InterBase API Session Handle
 	std::string mServerName;	// Server name
     std::string mDatabaseName;	// Database name (path/file)
@@ -831,10 +1068,56 @@ class DatabaseImpl : public IBPP::IDatabase
 	std::vector<ArrayImpl*> mArrays;		// Table of Array*
 	std::vector<EventsImpl*> mEvents;		// Table of Events*
 
+	// Prepared statements left by closed Statement objects, ready to be
+	// taken back by a Prepare() of the same SQL text. Most recently used first.
+	struct CachedStatement
+	{
+		isc_stmt_handle handle;
+		IBPP::STT type;
+		RowImpl* inRow;
+		RowImpl* outRow;
+		std::multimap<std::string, std::list<CachedStatement>::iterator>::iterator sql;
+	};
+	std::list<CachedStatement> mCache;
+	std::multimap<std::string, std::list<CachedStatement>::iterator> mCacheIndex;
+	int mCacheSize;							// Capacity, 0 disables the cache
+	int mCacheHits;
+	int mCacheMisses;
+	int mCacheEvictions;
+
+	// Names of the relations, by id, read on the first Statistics(DatabaseStats&)
+	// which meets an unknown id. Cleared once detached.
+	std::map<int, std::string> mRelationNames;
+
+	// Estimated rows of the relations, see RelationRows()
+	std::map<std::string, int64_t> mRelationRows;
+	bool mRelationRowsRead;
+
+#ifdef _DEBUG
+	friend class ThreadCheck;
+	std::atomic<std::thread::id> mThreadUser;	// Thread inside a call, if any
+	int mThreadDepth;							// Its nested calls
+#endif
+
+	void CacheEvict();
+	void RelationNames();
+
 public:
 	isc_db_handle* GetHandlePtr() { return &mHandle; }
 	isc_db_handle GetHandle() { return mHandle; }
 
+	bool CacheStatement(const std::string& sql, isc_stmt_handle handle,
+		IBPP::STT type, RowImpl* inRow, RowImpl* outRow);
+	bool UncacheStatement(const std::string& sql, isc_stmt_handle& handle,
+		IBPP::STT& type, RowImpl*& inRow, RowImpl*& outRow);
+	void ClearStatementCache();
+	int StatementCacheSize() { return mCacheSize; }
+
+	bool Alive();		// Attachment still valid on the server
+	IBPP::Database Clone();	// Another attachment, same parameters, connected
+	int64_t RelationRows(const std::string& relation);	// -1 when unknown
+	bool Busy();		// Transactions started or events queued
+
 	void AttachTransactionImpl(TransactionImpl*);
 	void DetachTransactionImpl(TransactionImpl*);
 	void AttachStatementImpl(StatementImpl*);
@@ -869,9 +1152,13 @@ public:
 	void Statistics(int* Fetches, int* Marks, int* Reads, int* Writes);
 	void Counts(int* Insert, int* Update, int* Delete,
 		int* ReadIdx, int* ReadSeq);
+	void Statistics(IBPP::DatabaseStats&);
 	void Users(std::vector<std::string>& users);
 	int Dialect() { return mDialect; }
 
+	void SetStatementCacheSize(int size);
+	void StatementCacheStatistics(int* Hits, int* Misses, int* Evictions);
+
     void Create(int dialect);
 	void Connect();
 	bool Connected() { return mHandle == 0 ? false : true; }
@@ -883,12 +1170,276 @@ public:
 	void Release();
 };
 
+//
+//	Implementation of IDatabasePool. The pool only holds the idle attachments,
+//	those handed out belong to their borrower until returned.
+//
+
+class DatabasePoolImpl : public IBPP::IDatabasePool
+{
+	//	(((((((( OBJECT INTERNALS ))))))))
+
+	static const int PINGAFTER;
+
+	struct IdleDatabase
+	{
+		IBPP::Database db;
+		std::chrono::steady_clock::time_point since;	// Returned at
+	};
+
+	RefCount mRefCount;			// Reference counter
+	std::string mServerName;	// Server name
+	std::string mDatabaseName;	// Database name (path/file)
+	std::string mUserName;		// User name
+	std::string mUserPassword;	// User password
+	std::string mRoleName;		// Role used for the attachments
+	std::string mCharSet;		// Character Set used for the attachments
+	std::vector<std::string> mWarmSql;	// Prepared on each new attachment
+	int mMinSize;
+	int mMaxSize;
+	int mIdleSeconds;			// 0 never closes idle attachments
+
+	std::mutex mLock;					// Guards mIdle and mOpen
+	std::condition_variable mReturned;	// Signaled when room is made
+	std::vector<IdleDatabase> mIdle;	// Most recently returned last
+	std::vector<DatabaseImpl*> mLent;	// Handed out by Acquire()
+	int mOpen;							// Idle, lent out or being opened
+
+	IBPP::Database Open();
+	void Evict(std::vector<IBPP::Database>& victims);
+	static void Discard(IBPP::Database&);
+
+public:
+	DatabasePoolImpl(const std::string& ServerName, const std::string& DatabaseName,
+				const std::string& UserName, const std::string& UserPassword,
+				const std::string& RoleName, const std::string& CharSet,
+				int MinSize, int MaxSize, int IdleSeconds,
+				const std::vector<std::string>& WarmSql);
+	~DatabasePoolImpl();
+
+	//	(((((((( OBJECT INTERFACE ))))))))
+
+public:
+	IBPP::Database Acquire(int WaitMs);
+	void Return(IBPP::Database&);
+	void EvictIdle();
+	void Sizes(int* Open, int* Idle);
+
+	IBPP::IDatabasePool* AddRef();
+	void Release();
+};
+
+//
+//	Implementation of IExecutor : a queue of work, run by one thread.
+//
+
+class ExecutorImpl : public IBPP::IExecutor
+{
+	//	(((((((( OBJECT INTERNALS ))))))))
+
+	RefCount mRefCount;				// Reference counter
+	IBPP::Database mDatabase;		// The attachment worked on
+
+	std::mutex mLock;				// Guards the members below
+	std::condition_variable mWake;	// Signaled on new work or stop
+	std::deque<std::function<void()> > mQueue;
+	std::function<void()> mNotify;
+	bool mStopping;
+	bool mOrphaned;					// Released by its own thread, see Loop()
+	std::thread mThread;			// Started last, once all is ready
+
+	void Loop();
+	void Post(const std::function<void()>&);
+
+	template <class T>
+	std::future<T> Submit(const std::function<T()>& work)
+	{
+		// std::function must be copyable, packaged_task is not
+		std::shared_ptr<std::packaged_task<T()> > task =
+			std::make_shared<std::packaged_task<T()> >(work);
+		std::future<T> result = task->get_future();
+		Post([task]() { (*task)(); });
+		return result;
+	}
+
+public:
+	ExecutorImpl(DatabaseImpl*);
+	~ExecutorImpl();
+
+	//	(((((((( OBJECT INTERFACE ))))))))
+
+public:
+	std::future<void> Run(const std::function<void()>& work);
+	std::future<void> ExecuteAsync(IBPP::Statement, const std::string& sql);
+	std::future<IBPP::Row> FetchAsync(IBPP::Statement);
+	std::future<void> CommitAsync(IBPP::Transaction);
+	void SetNotify(const std::function<void()>& notify);
+	IBPP::Database DatabasePtr() const;
+
+	IBPP::IExecutor* AddRef();
+	void Release();
+};
+
+//
+//	Implementation of IParallelScan. Each range is scanned by a thread of its
+//	own, which queues the rows (or batches) for the reading thread.
+//
+
+class ParallelScanImpl : public IBPP::IParallelScan
+{
+	//	(((((((( OBJECT INTERNALS ))))))))
+
+	static const int MAXROWS;		// Rows queued per range
+	static const int MAXBATCHES;	// Batches queued per range
+
+	struct Range
+	{
+		int64_t low;
+		int64_t high;
+		std::deque<IBPP::Row> rows;
+		std::deque<IBPP::ColumnBatch> batches;
+		bool done;					// Its thread ended
+		std::exception_ptr error;	// Why it ended, if it failed
+	};
+
+	RefCount mRefCount;				// Reference counter
+	IBPP::Database mDatabase;		// Parameters of the attachments
+	std::string mSql;
+	std::string mKey;
+	int mParts;
+	IBPP::PSO mOrder;
+	bool mRangeSet;
+	int64_t mLow;
+	int64_t mHigh;
+	bool mStarted;
+	int mBatchRows;					// 0 when read by Fetch()
+	int mNext;						// Range to look at first
+
+	std::mutex mLock;					// Guards mRanges and mStopping
+	std::condition_variable mFilled;	// Something queued, or a range done
+	std::condition_variable mEmptied;	// Room made, or stopping
+	std::vector<Range> mRanges;
+	bool mStopping;
+	std::vector<std::thread> mThreads;
+
+	void Start(int batchRows);
+	void Scan(int range);
+	bool Queue(int range, IBPP::Row&);
+	bool Queue(int range, IBPP::ColumnBatch&);
+	bool Queued(const Range&) const;
+	int Ready(std::unique_lock<std::mutex>&, std::exception_ptr& error);
+	void Stop();
+
+public:
+	ParallelScanImpl(IBPP::Database, const std::string& sql,
+		const std::string& key, int parts, IBPP::PSO order);
+	~ParallelScanImpl();
+
+	//	(((((((( OBJECT INTERFACE ))))))))
+
+public:
+	void SetRange(int64_t low, int64_t high);
+	bool Fetch(IBPP::Row&);
+	int FetchBatch(IBPP::ColumnBatch&, int rows);
+	void Close();
+
+	IBPP::IParallelScan* AddRef();
+	void Release();
+};
+
+class BulkLoaderImpl : public IBPP::IBulkLoader
+{
+	//	(((((((( OBJECT INTERNALS ))))))))
+
+	typedef std::chrono::steady_clock Clock;
+
+	static const int TAKEROWS;		// Rows run by one ExecuteBatch()
+	static const int MAXRETRIES;	// Runs of a row hitting lock conflicts
+	static const int MAXERRORS;		// Errors kept for Errors()
+
+	struct Queued
+	{
+		RowImpl* row;
+		int number;					// In the order of Add()
+		Clock::time_point added;
+	};
+
+	struct Part
+	{
+		std::deque<Queued> queue;
+		std::condition_variable work;	// Rows queued, flushing or stopping
+		int pending;				// Rows taken, not committed yet
+		bool ready;					// Connected and prepared
+		bool done;					// Its thread ended
+
+		Part() : pending(0), ready(false), done(false) { }
+	};
+
+	struct Committing				// What a partition will commit
+	{
+		int rows;					// Inserted rows
+		double addedMs;				// Sum of their Add() times
+		Clock::time_point oldest;
+		Clock::time_point due;		// Commit time, at the latest
+	};
+
+	RefCount mRefCount;				// Reference counter
+	IBPP::Database mDatabase;		// Parameters of the attachments
+	std::string mSql;
+	int mParts;
+	int mCommitRows;
+	int mCommitMs;
+	int64_t mBudget;
+	Clock::time_point mStart;
+
+	std::mutex mLock;				// Guards all that follows
+	std::condition_variable mDone;	// Rows taken or committed, a part ready or ended
+	std::deque<Part> mPartitions;
+	RowImpl* mShape;				// Parameters, as NewRow() returns them
+	int64_t mQueuedBytes;
+	int mFlushing;					// Flush() calls waiting
+	bool mStopping;
+	std::exception_ptr mError;		// First failure of a partition
+	IBPP::BulkLoaderStats mStats;
+	double mBatchMs;				// Sums behind the averages of mStats
+	int64_t mBatches;
+	double mLatencyMs;
+	std::vector<IBPP::BatchError> mErrors;
+	std::vector<std::thread> mThreads;
+
+	void Load(int part);
+	void Run(int part, IBPP::Transaction&, StatementImpl*, std::vector<Queued>&,
+		Committing&);
+	void Commit(int part, IBPP::Transaction&, Committing&);
+	bool Flushed();
+	void Stop();
+	static double Ms(Clock::time_point from, Clock::time_point to);
+
+public:
+	BulkLoaderImpl(IBPP::Database, const std::string& sql, int parts,
+		int commitRows, int commitMs, int64_t memoryBudget);
+	~BulkLoaderImpl();
+
+	//	(((((((( OBJECT INTERFACE ))))))))
+
+public:
+	IBPP::Row NewRow();
+	void Add(const IBPP::Row&);
+	void Flush();
+	void Close();
+	void Statistics(IBPP::BulkLoaderStats&);
+	void Errors(std::vector<IBPP::BatchError>&);
+
+	IBPP::IBulkLoader* AddRef();
+	void Release();
+};
+
 class TransactionImpl : public IBPP::ITransaction
 {
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
-	int mRefCount;					// Reference counter
+	RefCount mRefCount;				// Reference counter
     isc_tr_handle mHandle;			// Transaction InterBase
 
 	std::vector<DatabaseImpl*> mDatabases;   	// Tableau de IDatabase*
@@ -896,8 +1447,10 @@ private:
 	std::vector<BlobImpl*> mBlobs;				// Tableau de IBlob*
 	std::vector<ArrayImpl*> mArrays;			// Tableau de Array*
 	std::vector<TPB*> mTPBs;					// Tableau de TPB
+	PerfProbe mPerf;							// See SetPerfStats()
 
 	void Init();			// A usage exclusif des constructeurs
+	bool CommitCall(const char* context, IBS& status, bool retain);
 
 public:
 	isc_tr_handle* GetHandlePtr() { return &mHandle; }
@@ -911,12 +1464,15 @@ public:
 	void DetachArrayImpl(ArrayImpl*);
     void AttachDatabaseImpl(DatabaseImpl* dbi, IBPP::TAM am = IBPP::amWrite,
 			IBPP::TIL il = IBPP::ilConcurrency,
-			IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0));
+			IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0),
+			int lockTimeout = 0);
     void DetachDatabaseImpl(DatabaseImpl* dbi);
+	bool DatabaseAttached(DatabaseImpl* dbi) const;
 
 	TransactionImpl(DatabaseImpl* db, IBPP::TAM am = IBPP::amWrite,
 		IBPP::TIL il = IBPP::ilConcurrency,
-		IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0));
+		IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0),
+		int lockTimeout = 0);
     ~TransactionImpl();
 
 	//	(((((((( OBJECT INTERFACE ))))))))
@@ -924,7 +1480,8 @@ public:
 public:
     void AttachDatabase(IBPP::Database db, IBPP::TAM am = IBPP::amWrite,
 			IBPP::TIL il = IBPP::ilConcurrency,
-			IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0));
+			IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0),
+			int lockTimeout = 0);
     void DetachDatabase(IBPP::Database db);
 	void AddReservation(IBPP::Database db,
 			const std::string& table, IBPP::TTR tr);
@@ -935,6 +1492,10 @@ public:
     void Rollback();
     void CommitRetain();
 	void RollbackRetain();
+	IBPP::Status TryCommit();
+	IBPP::Status TryCommitRetain();
+	void SetPerfStats(bool on) { mPerf.Enable(on); }
+	void PerfStatistics(IBPP::PerfStats& stats) { mPerf.Last(stats); }
 
 	IBPP::ITransaction* AddRef();
 	void Release();
@@ -945,9 +1506,11 @@ class RowImpl : public IBPP::IRow
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
-	int mRefCount;					// Reference counter
+	RefCount mRefCount;				// Reference counter
 
 	XSQLDA* mDescrArea;				// XSQLDA descriptor itself
+	char* mBuffer;					// Storage of all sqldata and sqlind
+	int mBufferSize;				// Size of this buffer in bytes
 	std::vector<double> mNumerics;	// Temporary storage for Numerics
 	std::vector<float> mFloats;	 	// Temporary storage for Floats
 	std::vector<int64_t> mInt64s;	// Temporary storage for 64 bits
@@ -956,13 +1519,20 @@ private:
 	std::vector<char> mBools;		// Temporary storage for Bools
 	std::vector<std::string> mStrings;	// Temporary storage for Strings
 	std::vector<bool> mUpdated;		// Which columns where updated (Set()) ?
+	std::vector<int16_t> mColumnIndex;	// Hashed column names and aliases
 
 	int mDialect;					// Related database dialect
 	DatabaseImpl* mDatabase;		// Related Database (important for Blobs, ...)
 	TransactionImpl* mTransaction;	// Related Transaction (same remark)
+	RowPool* mPool;					// Pool to return to when released, if any
+
+	friend class RowPool;
 
 	void SetValue(int, IITYPE, const void* value, int = 0);
 	void* GetValue(int, IITYPE, void* = 0);
+	void IndexColumns();
+	static size_t ColumnHash(const char* name, size_t len);
+	bool SameColumn(int slot, const char* name, size_t len);
 
 public:
 	void Free();
@@ -970,6 +1540,11 @@ public:
 	void Resize(int n);
 	void AllocVariables();
 	bool MissingValues();		// Returns wether one of the mMissing[] is true
+	bool CopyColumn(int, const RowImpl& src, int srcnum);
+	void ClearUpdated() { mUpdated.assign(mUpdated.size(), false); }
+	int BufferSize() { return mBufferSize; }
+	void SetTransaction(TransactionImpl* tr) { mTransaction = tr; }
+	void SetDatabase(DatabaseImpl* db) { mDatabase = db; }
 	XSQLDA* Self() { return mDescrArea; }
 
 	RowImpl& operator=(const RowImpl& copied);
@@ -1032,6 +1607,7 @@ public:
 	bool Get(const std::string&, IBPP::Array&);
 
 	int ColumnNum(const std::string&);
+	IBPP::ColumnHandle Column(const std::string&);
 	const char* ColumnName(int);
 	const char* ColumnAlias(int);
 	const char* ColumnTable(int);
@@ -1059,7 +1635,7 @@ class StatementImpl : public IBPP::IStatement
 private:
 	friend class TransactionImpl;
 
-	int mRefCount;				// Reference counter
+	RefCount mRefCount;			// Reference counter
 	isc_stmt_handle mHandle;	// Statement Handle
 
 	DatabaseImpl* mDatabase;		// Attached database
@@ -1067,17 +1643,58 @@ private:
 	RowImpl* mInRow;
 	//bool* mInMissing;			// Quels paramtres n'ont pas t spcifis
 	RowImpl* mOutRow;
+	RowPool* mRowPool;			// Rows recycled by Fetch(Row&)
+	Prefetcher* mPrefetch;		// Fetching ahead, see Prefetch()
+	QueryProfile* mProfile;		// Statistics of mSql, see Profile()
+	PerfProbe mPerf;			// See SetPerfStats()
+	int mPrefetchStats[3];		// Rows, stalls, waits of the last Prefetch()
 	bool mResultSetAvailable;	// Executed and result set is available
 	bool mCursorOpened;			// dsql_set_cursor_name was called
+	bool mCacheable;			// Close() may hand the handle over to the cache
 	IBPP::STT mType;			// Type de requte
 	std::string mSql;			// Last SQL statement prepared or executed
 
+	// How FetchBatch() stores each output column, decided once after Prepare
+	// (bkNone for the blobs and arrays, which it can't read)
+	enum BatchCopy {bkInt16, bkInt32, bkInt64, bkFloat, bkDouble,
+		bkDate, bkTime, bkTimestamp, bkText, bkVarying, bkNone};
+	std::vector<BatchCopy> mBatchCopies;
+	bool mBatchEnded;			// FetchBatch() met the end of the result set
+
+	// Parameter rows queued by AddBatch(), and the EXECUTE BLOCK statements
+	// which run them by chunks, one per count of rows
+	std::vector<RowImpl*> mBatch;
+	std::vector<std::pair<int, StatementImpl*> > mBatchBlocks;
+	bool mBatchBlocksFailed;	// Server can't run them, go row by row
+
 	// Internal Methods
+	const char* ExecuteCall(const char* context, IBS& status, bool* singleton = 0);
+	int FetchCall(IBS& status);
+	QueryProfile* Profile();
+	void PlanCheck();
 	void CursorFree();
+	void Unprepare();
+	RowImpl* PrefetchNext(const char* context, IBS* failed = 0);
+	void PrefetchStop();
+	void SizeRow(RowImpl*&, int columns);
+	bool DescribeFromInfo(char*& info, char section, RowImpl*&);
+	void Describe(RowImpl*&, bool input);
+	void BatchDescribe();
+	void BatchSetup(IBPP::ColumnBatch&);
+	void BatchFree();
+	int BatchChunk(int rows);
+	std::string BatchBlockSql(int rows);
+	bool BatchRunBlock(int first, int count, std::vector<int>& affected);
+	void BatchRunSplit(int first, int count, std::vector<int>& affected,
+		std::vector<IBPP::BatchError>& errors);
+	void BatchRunRows(int first, int count, std::vector<int>& affected,
+		std::vector<IBPP::BatchError>& errors);
 
 public:
 	// Properties and Attributes Access Methods
 	isc_stmt_handle GetHandle() { return mHandle; }
+	RowImpl* ParametersRow() { return mInRow; }
+	void AddBatch(RowImpl*);		// Queues that row itself, not a copy
 
 	void AttachDatabaseImpl(DatabaseImpl*);
 	void DetachDatabaseImpl();
@@ -1093,11 +1710,24 @@ public:
 	void Prepare(const std::string& sql);
 	void Execute(const std::string& sql);
 	inline void Execute()	{ Execute(std::string()); }
+	bool ExecuteSingleton(const std::string& sql);
+	inline bool ExecuteSingleton()	{ return ExecuteSingleton(std::string()); }
 	void ExecuteImmediate(const std::string&);
 	void CursorExecute(const std::string& cursor, const std::string& sql);
 	inline void CursorExecute(const std::string& cursor)	{ CursorExecute(cursor, std::string()); }
 	bool Fetch();
 	bool Fetch(IBPP::Row&);
+	IBPP::Status TryExecute();
+	IBPP::Status TryFetch(bool& fetched);
+	int FetchBatch(IBPP::ColumnBatch&, int rows);
+	void Prefetch(int RingSize, IBPP::PFP policy);
+	void PrefetchStatistics(int* Rows, int* Stalls, int* Waits);
+	void SetPerfStats(bool on) { mPerf.Enable(on); }
+	void PerfStatistics(IBPP::PerfStats& stats) { mPerf.Last(stats); }
+	void AddBatch();
+	void ClearBatch();
+	void ExecuteBatch(std::vector<int>& affected,
+		std::vector<IBPP::BatchError>& errors, int chunk);
 	int AffectedRows();
 	void Close();	// Free resources, attachments maintained
 	std::string& Sql() { return mSql; }
@@ -1167,6 +1797,7 @@ public:
 	bool Get(const std::string&, IBPP::Array&);
 
 	int ColumnNum(const std::string&);
+	IBPP::ColumnHandle Column(const std::string&);
     int ColumnNumAlias(const std::string&);
 	const char* ColumnName(int);
 	const char* ColumnAlias(int);
@@ -1184,7 +1815,9 @@ public:
 	int Parameters();
 
 	void Plan(std::string&);
+	void Plan(std::vector<IBPP::PlanNode>&);
 
+	void AttachTransaction(IBPP::Transaction);
 	IBPP::Database DatabasePtr() const;
 	IBPP::Transaction TransactionPtr() const;
 
@@ -1199,7 +1832,7 @@ class BlobImpl : public IBPP::IBlob
 private:
 	friend class RowImpl;
 
-	int mRefCount;
+	RefCount mRefCount;
 	bool					mIdAssigned;
 	ISC_QUAD				mId;
 	isc_blob_handle			mHandle;
@@ -1249,7 +1882,7 @@ class ArrayImpl : public IBPP::IArray
 private:
 	friend class RowImpl;
 
-	int					mRefCount;		// Reference counter
+	RefCount			mRefCount;		// Reference counter
 	bool				mIdAssigned;
 	ISC_QUAD			mId;
 	bool				mDescribed;
@@ -1350,7 +1983,7 @@ class EventsImpl : public IBPP::IEvents
 	Buffer mEventBuffer;
 	Buffer mResultsBuffer;
 
-	int mRefCount;		// Reference counter
+	RefCount mRefCount;	// Reference counter
 
 	DatabaseImpl* mDatabase;
 	ISC_LONG mId;			// Firebird internal Id of these events
@@ -1395,6 +2028,9 @@ void decodeTime(IBPP::Time& tm, const ISC_TIME& isc_tm);
 void encodeTimestamp(ISC_TIMESTAMP& isc_ts, const IBPP::Timestamp& ts);
 void decodeTimestamp(IBPP::Timestamp& ts, const ISC_TIMESTAMP& isc_ts);
 
+bool lockConflict(int enginecode);	// Worth running the same work again
+int64_t infoInteger(const char* p, int len);	// Of an info reply, 1 to 8 bytes
+
 struct consts	// See _ibpp.cpp for initializations of these constants
 {
 	static const double dscales[19];
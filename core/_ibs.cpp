@@ -102,6 +102,81 @@ IBS::IBS(IBS& copied)
 	memcpy(mVector, copied.mVector, sizeof(mVector));
 }
 
+//	(((((((( IBPP::Status ))))))))
+
+// Arguments pointing to a null terminated string. isc_arg_sql_state (19)
+// comes with Firebird 2.5, after the headers of IBPP.
+static bool StringArg(long arg)
+{
+	return arg == isc_arg_string || arg == isc_arg_interpreted || arg == 19;
+}
+
+IBPP::Status::Status()
+	: mContext("")
+{
+	for (int i = 0; i < 20; i++) mVector[i] = 0;
+}
+
+IBPP::Status::Status(const long* vector, const char* context)
+	: mContext(context)
+{
+	// The string arguments point into storage of the client library which
+	// the next call reuses : they are copied, their offsets kept instead.
+	memcpy(mVector, vector, sizeof(mVector));
+	for (int i = 1; i < 20 && mVector[i-1] != isc_arg_end; i += 2)
+	{
+		long arg = mVector[i-1];
+		if (arg == isc_arg_cstring && i < 19)
+		{
+			const char* text = (const char*)vector[i+1];
+			long offset = (long)mStrings.size();
+			mStrings.append(text, (size_t)mVector[i]).append(1, '\0');
+			mVector[++i] = offset;
+		}
+		else if (StringArg(arg))
+		{
+			const char* text = (const char*)vector[i];
+			long offset = (long)mStrings.size();
+			mStrings.append(text).append(1, '\0');
+			mVector[i] = offset;
+		}
+	}
+}
+
+void IBPP::Status::Vector(long* vector) const
+{
+	// Back from offsets to pointers, into mStrings this time
+	memcpy(vector, mVector, sizeof(mVector));
+	for (int i = 1; i < 20 && vector[i-1] != isc_arg_end; i += 2)
+	{
+		long arg = vector[i-1];
+		if (arg == isc_arg_cstring && i < 19) ++i;
+		else if (! StringArg(arg)) continue;
+		vector[i] = (long)(mStrings.data() + vector[i]);
+	}
+}
+
+int IBPP::Status::SqlCode() const
+{
+	if (Ok()) return 0;
+	long vector[20];
+	Vector(vector);
+	return (int)(*gds.Call()->m_sqlcode)((ISC_STATUS*)vector);
+}
+
+const char* IBPP::Status::Message() const
+{
+	// Formatted by IBS, as for an SQLException, once asked for
+	if (Ok()) return "";
+	if (mMessage.empty())
+	{
+		IBS status;
+		Vector((long*)status.Self());
+		mMessage.assign(mContext).append("\n").append(status.ErrorMessage());
+	}
+	return mMessage.c_str();
+}
+
 //
 //	EOF
 //
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, PerfStats and internal PerfProbe class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <ctime>
+
+using namespace ibpp_internals;
+
+//	(((((((( IBPP::PerfStats ))))))))
+
+IBPP::PerfStats IBPP::PerfStats::operator-(const IBPP::PerfStats& before) const
+{
+	// As perf_diff() of Firebird : the counters and the times are differences,
+	// the memory and the cache figures those of the later snapshot.
+	IBPP::PerfStats delta(*this);
+	delta.fetches -= before.fetches;
+	delta.marks -= before.marks;
+	delta.reads -= before.reads;
+	delta.writes -= before.writes;
+	delta.deltaMemory = currentMemory - before.currentMemory;
+	delta.elapsedMs -= before.elapsedMs;
+	delta.cpuMs -= before.cpuMs;
+	return delta;
+}
+
+//	(((((((( PerfProbe ))))))))
+
+void PerfProbe::Take(DatabaseImpl* const* databases, size_t count,
+	IBPP::PerfStats& stats)
+{
+	// The page counters and the memory add up over the attachments, the cache
+	// figures are those of the first one
+	stats = IBPP::PerfStats();
+	for (size_t d = 0; d < count; d++)
+	{
+		if (databases[d] == 0 || databases[d]->GetHandle() == 0) continue;
+
+		char items[] = {isc_info_fetches,
+						isc_info_marks,
+						isc_info_reads,
+						isc_info_writes,
+						isc_info_current_memory,
+						isc_info_max_memory,
+						isc_info_num_buffers,
+						isc_info_page_size,
+						isc_info_end};
+		IBS status;
+		RB result(256);
+
+		(*gds.Call()->m_database_info)(status.Self(), databases[d]->GetHandlePtr(),
+			sizeof(items), items, result.Size(), result.Self());
+		if (status.Errors())
+			throw SQLExceptionImpl(status, "PerfStats", _("isc_database_info failed"));
+
+		const char* p = result.Self();
+		const char* end = p + result.Size();
+		while (p + 3 <= end && *p != isc_info_end && *p != isc_info_truncated)
+		{
+			const char item = *p;
+			const int len = (int)infoInteger(p + 1, 2) & 0xFFFF;
+			p += 3;
+			if (p + len > end) break;
+			const int64_t value = len <= 8 ? infoInteger(p, len) : 0;
+			switch (item)
+			{
+				case isc_info_fetches :			stats.fetches += value; break;
+				case isc_info_marks :			stats.marks += value; break;
+				case isc_info_reads :			stats.reads += value; break;
+				case isc_info_writes :			stats.writes += value; break;
+				case isc_info_current_memory :	stats.currentMemory += value; break;
+				case isc_info_max_memory :		stats.maxMemory += value; break;
+				case isc_info_num_buffers :
+					if (stats.buffers == 0) stats.buffers = (int)value;
+					break;
+				case isc_info_page_size :
+					if (stats.pageSize == 0) stats.pageSize = (int)value;
+					break;
+			}
+			p += len;
+		}
+	}
+
+	stats.elapsedMs = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	stats.cpuMs = std::clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+void PerfProbe::Begin(DatabaseImpl* const* databases, size_t count)
+{
+	if (! mOn) return;
+	Take(databases, count, mStart);
+	mOpen = true;
+}
+
+void PerfProbe::End(DatabaseImpl* const* databases, size_t count)
+{
+	// Called on the way out of failed calls and from CursorFree() : a failure
+	// to measure simply leaves the previous measure in place.
+	if (! mOpen) return;
+	mOpen = false;
+	try
+	{
+		IBPP::PerfStats now;
+		Take(databases, count, now);
+		mLast = now - mStart;
+	}
+	catch (...) { }
+}
+
+//
+//	EOF
+//
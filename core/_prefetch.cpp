@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, internal Prefetcher class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+using namespace ibpp_internals;
+
+//	A pfGrow ring stops growing there and waits for the consumer as pfWait
+//	does, so that a stalled consumer can't exhaust the memory.
+const int Prefetcher::GROWMAX = 65536;
+
+RowImpl* Prefetcher::Pop(IBS*& error, std::exception_ptr& failure)
+{
+	std::unique_lock<std::mutex> guard(mLock);
+	if (mReady.empty() && ! mEnd)
+	{
+		++mStalls;		// The consumer caught up with the fetches
+		while (mReady.empty() && ! mEnd) mFilled.wait(guard);
+	}
+
+	// The error, if any, only matters once the rows before it are read
+	error = mError;
+	failure = mFailure;
+	if (mReady.empty()) return 0;
+
+	RowImpl* row = mReady.front();
+	mReady.pop_front();
+	mEmptied.notify_one();
+	return row;
+}
+
+void Prefetcher::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		mStopping = true;
+	}
+	mEmptied.notify_one();
+
+	// A fetch in progress completes first
+	if (mThread.joinable()) mThread.join();
+	while (! mReady.empty())
+	{
+		Discard(mReady.front());
+		mReady.pop_front();
+	}
+}
+
+void Prefetcher::Statistics(int* Rows, int* Stalls, int* Waits)
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	if (Rows != 0) *Rows = mRows;
+	if (Stalls != 0) *Stalls = mStalls;
+	if (Waits != 0) *Waits = mWaits;
+}
+
+void Prefetcher::Loop()
+{
+	for (;;)
+	{
+		{
+			const int limit = mPolicy == IBPP::pfWait ? mRingSize
+				: (mRingSize > GROWMAX ? mRingSize : GROWMAX);
+			std::unique_lock<std::mutex> guard(mLock);
+			if ((int)mReady.size() >= limit && ! mStopping)
+			{
+				++mWaits;	// The consumer is the slower one
+				while ((int)mReady.size() >= limit && ! mStopping)
+					mEmptied.wait(guard);
+			}
+			if (mStopping) return;
+		}
+
+		RowImpl* row = 0;
+		try
+		{
+			// Fetched outside of the lock, so that the consumer keeps going
+			row = mPool->Take(*mShape);
+			IBS status;
+			int code = (*gds.Call()->m_dsql_fetch)(status.Self(), mHandle, 1, row->Self());
+
+			std::lock_guard<std::mutex> guard(mLock);
+			if (code == 100 || status.Errors())
+			{
+				// This special code 100 means "no more rows"
+				Discard(row);
+				row = 0;
+				if (code != 100) mError = new IBS(status);
+				mEnd = true;
+				mFilled.notify_one();
+				return;
+			}
+			mReady.push_back(row);
+			++mRows;
+			mFilled.notify_one();
+		}
+		catch (...)
+		{
+			// Most probably out of memory : the consumer gets the exception
+			// once it has read the rows before it
+			if (row != 0) Discard(row);
+			std::lock_guard<std::mutex> guard(mLock);
+			mFailure = std::current_exception();
+			mEnd = true;
+			mFilled.notify_one();
+			return;
+		}
+	}
+}
+
+void Prefetcher::Discard(RowImpl* row)
+{
+	// Back to the pool, as when the last Row pointing to it goes away
+	row->AddRef();
+	row->Release();
+}
+
+Prefetcher::Prefetcher(isc_stmt_handle* handle, const RowImpl& shape,
+	RowPool* pool, int size, IBPP::PFP policy)
+	: mHandle(handle), mShape(new RowImpl(shape)), mPool(pool),
+	mRingSize(size), mPolicy(policy), mEnd(false), mStopping(false),
+	mError(0), mRows(0), mStalls(0), mWaits(0)
+{
+	// The thread copies new rows from mShape, not from the statement's
+	// output row, which the consumer keeps overwriting.
+	mPool->AddRef();
+	try { mThread = std::thread(&Prefetcher::Loop, this); }
+	catch (...)
+	{
+		mPool->Release();
+		delete mShape;
+		throw;
+	}
+}
+
+Prefetcher::~Prefetcher()
+{
+	try { Stop(); }
+		catch (...) { }
+	delete mError;
+	delete mShape;
+	mPool->Release();
+}
+
+//
+//	EOF
+//
@@ -40,6 +40,17 @@
 
 using namespace ibpp_internals;
 
+int64_t ibpp_internals::infoInteger(const char* p, int len)
+{
+	// Same little-endian encoding as isc_vax_integer(), but up to 8 bytes
+	uint64_t value = 0;
+	for (int i = len - 1; i >= 0; i--)
+		value = (value << 8) | (unsigned char)p[i];
+	if (len > 0 && len < 8 && (p[len-1] & 0x80) != 0)
+		value |= ~uint64_t(0) << (8 * len);		// Sign extension
+	return (int64_t)value;
+}
+
 char* RB::FindToken(char token)
 {
 	char* p = mBuffer;
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, internal RowPool class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* RB == Result Block/Buffer, see Interbase 6.0 C-API
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+using namespace ibpp_internals;
+
+//	Maximum count of released rows a pool keeps for re-use. Beyond that,
+//	released rows are simply deleted.
+const int RowPool::MAXIDLE = 32;
+
+RowImpl* RowPool::Take(const RowImpl& shape)
+{
+	RowImpl* row = 0;
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		if (! mIdle.empty())
+		{
+			row = mIdle.back();
+			mIdle.pop_back();
+		}
+	}
+
+	// An idle row already has the right descriptor and storage, the
+	// next fetch will overwrite all of its data.
+	if (row == 0) row = new RowImpl(shape);
+	else row->mUpdated.assign(row->mUpdated.size(), false);
+
+	row->mPool = this;
+	++mRefCount;
+	return row;
+}
+
+bool RowPool::Recycle(RowImpl* row)
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	if (! mOpen || (int)mIdle.size() >= MAXIDLE) return false;
+	mIdle.push_back(row);
+	return true;
+}
+
+void RowPool::Drain()
+{
+	std::vector<RowImpl*> idle;
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		mOpen = false;
+		idle.swap(mIdle);
+	}
+	while (! idle.empty())
+	{
+		delete idle.back();
+		idle.pop_back();
+	}
+}
+
+void RowPool::Release()
+{
+	if (--mRefCount <= 0) delete this;
+}
+
+RowPool::~RowPool()
+{
+	try { Drain(); }
+		catch (...) { }
+}
+
+//
+//	EOF
+//
@@ -73,6 +73,16 @@ void TPB::Insert(char item)
 	mBuffer[mSize++] = item;
 }
 
+void TPB::Insert(char item, int32_t value)
+{
+	// The value is stored least significant byte first, after its length
+	Grow(2 + 4);
+	mBuffer[mSize++] = item;
+	mBuffer[mSize++] = char(4);
+	for (int i = 0; i < 4; i++)
+		mBuffer[mSize++] = char((value >> (8 * i)) & 0xFF);
+}
+
 void TPB::Insert(const std::string& data)
 {
 	int len = (int)data.length();
@@ -0,0 +1,526 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, internal tracing of the client library calls
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <map>
+
+using namespace ibpp_internals;
+
+//	The observer, and the table of entry points GDS::Call() returns while
+//	there is one : the same as gds, except that each call of the server goes
+//	through one of the trace...() functions below.
+static std::atomic<IBPP::ITraceObserver*> observer(0);
+static GDS traced;
+static std::once_flag tracedReady;
+
+//	Calls in progress, counted by epoch : SetTraceObserver() starts a new
+//	epoch, then waits for the calls of the previous one, which may still be
+//	using the previous observer. Those of the new epoch see the new one.
+static std::mutex observerLock;
+static std::atomic<unsigned> epoch(0);
+static std::atomic<int> inFlight[2];
+
+//	Text of the statements prepared while tracing, by handle
+static std::mutex statementsLock;
+static std::map<isc_stmt_handle, std::string> statements;
+
+static std::string StatementSql(isc_stmt_handle handle)
+{
+	std::lock_guard<std::mutex> guard(statementsLock);
+	std::map<isc_stmt_handle, std::string>::const_iterator it = statements.find(handle);
+	return it == statements.end() ? std::string() : it->second;
+}
+
+static int64_t DataBytes(const XSQLDA* da)
+{
+	int64_t bytes = 0;
+	if (da != 0)
+		for (int i = 0; i < da->sqld; i++)
+			bytes += da->sqlvar[i].sqllen;
+	return bytes;
+}
+
+static bool Failed(const ISC_STATUS* status)
+{
+	return status[0] == 1 && status[1] > 0;
+}
+
+//	One call of the client library, told to the observer before and after
+class TraceCall
+{
+	IBPP::ITraceObserver* mObserver;
+	IBPP::TraceEvent mEvent;
+	FB_API_HANDLE* mHandle;
+	std::string mSql;
+	std::chrono::steady_clock::time_point mStart;
+	unsigned mEpoch;
+
+public:
+	void Bytes(int64_t bytes) { mEvent.bytes += bytes; }
+	ISC_STATUS Done(const ISC_STATUS* status, ISC_STATUS result);
+
+	TraceCall(IBPP::TOP op, FB_API_HANDLE* handle,
+		const std::string& sql = std::string(), int64_t bytes = 0);
+	~TraceCall() { --inFlight[mEpoch & 1]; }
+};
+
+TraceCall::TraceCall(IBPP::TOP op, FB_API_HANDLE* handle,
+	const std::string& sql, int64_t bytes)
+	: mHandle(handle), mSql(sql)
+{
+	// Counted in the epoch which is still current once counted
+	for (;;)
+	{
+		mEpoch = epoch.load();
+		++inFlight[mEpoch & 1];
+		if (epoch.load() == mEpoch) break;
+		--inFlight[mEpoch & 1];
+	}
+	mObserver = observer.load();
+
+	mEvent.op = op;
+	mEvent.object = handle == 0 ? 0 : (uintptr_t)*handle;
+	mEvent.sql = mSql.empty() ? 0 : mSql.c_str();
+	mEvent.bytes = bytes;
+	if (mObserver != 0)
+	{
+		try { mObserver->Before(mEvent); }
+			catch (...) { }
+	}
+	mStart = std::chrono::steady_clock::now();
+}
+
+ISC_STATUS TraceCall::Done(const ISC_STATUS* status, ISC_STATUS result)
+{
+	if (mObserver == 0) return result;	// Stopped meanwhile
+
+	mEvent.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - mStart).count();
+	mEvent.object = mHandle == 0 ? 0 : (uintptr_t)*mHandle;
+	mEvent.failed = Failed(status);
+	try { mObserver->After(mEvent); }
+		catch (...) { }
+	return result;
+}
+
+//	(((((((( ATTACHMENTS ))))))))
+
+static ISC_STATUS ISC_EXPORT traceCreateDatabase(ISC_STATUS* status, short length,
+	char* name, isc_db_handle* db, short dpblength, char* dpb, short type)
+{
+	TraceCall call(IBPP::toCreateDatabase, db);
+	return call.Done(status, (*gds.m_create_database)(status, length, name, db,
+		dpblength, dpb, type));
+}
+
+static ISC_STATUS ISC_EXPORT traceAttachDatabase(ISC_STATUS* status, short length,
+	char* name, isc_db_handle* db, short dpblength, char* dpb)
+{
+	TraceCall call(IBPP::toAttachDatabase, db);
+	return call.Done(status, (*gds.m_attach_database)(status, length, name, db,
+		dpblength, dpb));
+}
+
+static ISC_STATUS ISC_EXPORT traceDetachDatabase(ISC_STATUS* status, isc_db_handle* db)
+{
+	TraceCall call(IBPP::toDetachDatabase, db);
+	return call.Done(status, (*gds.m_detach_database)(status, db));
+}
+
+static ISC_STATUS ISC_EXPORT traceDropDatabase(ISC_STATUS* status, isc_db_handle* db)
+{
+	TraceCall call(IBPP::toDropDatabase, db);
+	return call.Done(status, (*gds.m_drop_database)(status, db));
+}
+
+static ISC_STATUS ISC_EXPORT traceDatabaseInfo(ISC_STATUS* status, isc_db_handle* db,
+	short itemslength, char* items, short length, char* buffer)
+{
+	TraceCall call(IBPP::toDatabaseInfo, db, std::string(), length);
+	return call.Done(status, (*gds.m_database_info)(status, db, itemslength,
+		items, length, buffer));
+}
+
+//	(((((((( TRANSACTIONS ))))))))
+
+static ISC_STATUS ISC_EXPORT traceStartMultiple(ISC_STATUS* status, isc_tr_handle* tr,
+	short count, void* teb)
+{
+	TraceCall call(IBPP::toStartTransaction, tr);
+	return call.Done(status, (*gds.m_start_multiple)(status, tr, count, teb));
+}
+
+static ISC_STATUS ISC_EXPORT traceCommit(ISC_STATUS* status, isc_tr_handle* tr)
+{
+	TraceCall call(IBPP::toCommit, tr);
+	return call.Done(status, (*gds.m_commit_transaction)(status, tr));
+}
+
+static ISC_STATUS ISC_EXPORT traceCommitRetaining(ISC_STATUS* status, isc_tr_handle* tr)
+{
+	TraceCall call(IBPP::toCommitRetaining, tr);
+	return call.Done(status, (*gds.m_commit_retaining)(status, tr));
+}
+
+static ISC_STATUS ISC_EXPORT traceRollback(ISC_STATUS* status, isc_tr_handle* tr)
+{
+	TraceCall call(IBPP::toRollback, tr);
+	return call.Done(status, (*gds.m_rollback_transaction)(status, tr));
+}
+
+static ISC_STATUS ISC_EXPORT traceRollbackRetaining(ISC_STATUS* status, isc_tr_handle* tr)
+{
+	TraceCall call(IBPP::toRollbackRetaining, tr);
+	return call.Done(status, (*gds.m_rollback_retaining)(status, tr));
+}
+
+//	(((((((( STATEMENTS ))))))))
+
+static ISC_STATUS ISC_EXPORT traceExecuteImmediate(ISC_STATUS* status, isc_db_handle* db,
+	isc_tr_handle* tr, unsigned short length, char* sql, unsigned short dialect,
+	XSQLDA* da)
+{
+	TraceCall call(IBPP::toExecuteImmediate, tr,
+		length == 0 ? std::string(sql) : std::string(sql, length), DataBytes(da));
+	return call.Done(status, (*gds.m_dsql_execute_immediate)(status, db, tr,
+		length, sql, dialect, da));
+}
+
+static ISC_STATUS ISC_EXPORT traceAllocateStatement(ISC_STATUS* status,
+	isc_db_handle* db, isc_stmt_handle* stmt)
+{
+	TraceCall call(IBPP::toAllocateStatement, stmt);
+	return call.Done(status, (*gds.m_dsql_allocate_statement)(status, db, stmt));
+}
+
+static ISC_STATUS ISC_EXPORT tracePrepare(ISC_STATUS* status, isc_tr_handle* tr,
+	isc_stmt_handle* stmt, unsigned short length, char* sql, unsigned short dialect,
+	XSQLDA* da)
+{
+	std::string text = length == 0 ? std::string(sql) : std::string(sql, length);
+	TraceCall call(IBPP::toPrepare, stmt, text);
+	ISC_STATUS result = (*gds.m_dsql_prepare)(status, tr, stmt, length, sql,
+		dialect, da);
+	if (! Failed(status))
+	{
+		std::lock_guard<std::mutex> guard(statementsLock);
+		statements[*stmt] = text;
+	}
+	return call.Done(status, result);
+}
+
+static ISC_STATUS ISC_EXPORT traceDescribe(ISC_STATUS* status, isc_stmt_handle* stmt,
+	unsigned short version, XSQLDA* da)
+{
+	TraceCall call(IBPP::toDescribe, stmt, StatementSql(*stmt));
+	return call.Done(status, (*gds.m_dsql_describe)(status, stmt, version, da));
+}
+
+static ISC_STATUS ISC_EXPORT traceDescribeBind(ISC_STATUS* status, isc_stmt_handle* stmt,
+	unsigned short version, XSQLDA* da)
+{
+	TraceCall call(IBPP::toDescribeBind, stmt, StatementSql(*stmt));
+	return call.Done(status, (*gds.m_dsql_describe_bind)(status, stmt, version, da));
+}
+
+static ISC_STATUS ISC_EXPORT traceExecute(ISC_STATUS* status, isc_tr_handle* tr,
+	isc_stmt_handle* stmt, unsigned short version, XSQLDA* in)
+{
+	TraceCall call(IBPP::toExecute, stmt, StatementSql(*stmt), DataBytes(in));
+	return call.Done(status, (*gds.m_dsql_execute)(status, tr, stmt, version, in));
+}
+
+static ISC_STATUS ISC_EXPORT traceExecute2(ISC_STATUS* status, isc_tr_handle* tr,
+	isc_stmt_handle* stmt, unsigned short version, XSQLDA* in, XSQLDA* out)
+{
+	TraceCall call(IBPP::toExecute2, stmt, StatementSql(*stmt), DataBytes(in));
+	ISC_STATUS result = (*gds.m_dsql_execute2)(status, tr, stmt, version, in, out);
+	if (result == 0) call.Bytes(DataBytes(out));
+	return call.Done(status, result);
+}
+
+static ISC_STATUS ISC_EXPORT traceFetch(ISC_STATUS* status, isc_stmt_handle* stmt,
+	unsigned short version, XSQLDA* out)
+{
+	TraceCall call(IBPP::toFetch, stmt, StatementSql(*stmt));
+	ISC_STATUS result = (*gds.m_dsql_fetch)(status, stmt, version, out);
+	if (result == 0) call.Bytes(DataBytes(out));
+	return call.Done(status, result);
+}
+
+static ISC_STATUS ISC_EXPORT traceFreeStatement(ISC_STATUS* status, isc_stmt_handle* stmt,
+	unsigned short option)
+{
+	const isc_stmt_handle handle = *stmt;
+	TraceCall call(IBPP::toFreeStatement, stmt, StatementSql(handle));
+	ISC_STATUS result = (*gds.m_dsql_free_statement)(status, stmt, option);
+	if (option == DSQL_drop)
+	{
+		std::lock_guard<std::mutex> guard(statementsLock);
+		statements.erase(handle);
+	}
+	return call.Done(status, result);
+}
+
+static ISC_STATUS ISC_EXPORT traceSetCursorName(ISC_STATUS* status, isc_stmt_handle* stmt,
+	char* name, unsigned short type)
+{
+	TraceCall call(IBPP::toSetCursorName, stmt, StatementSql(*stmt));
+	return call.Done(status, (*gds.m_dsql_set_cursor_name)(status, stmt, name, type));
+}
+
+static ISC_STATUS ISC_EXPORT traceStatementInfo(ISC_STATUS* status, isc_stmt_handle* stmt,
+	short itemslength, char* items, short length, char* buffer)
+{
+	TraceCall call(IBPP::toStatementInfo, stmt, StatementSql(*stmt), length);
+	return call.Done(status, (*gds.m_dsql_sql_info)(status, stmt, itemslength,
+		items, length, buffer));
+}
+
+//	(((((((( BLOBS AND ARRAYS ))))))))
+
+static ISC_STATUS ISC_EXPORT traceOpenBlob(ISC_STATUS* status, isc_db_handle* db,
+	isc_tr_handle* tr, isc_blob_handle* blob, ISC_QUAD* id, short bpblength, char* bpb)
+{
+	TraceCall call(IBPP::toOpenBlob, blob);
+	return call.Done(status, (*gds.m_open_blob2)(status, db, tr, blob, id,
+		bpblength, bpb));
+}
+
+static ISC_STATUS ISC_EXPORT traceCreateBlob(ISC_STATUS* status, isc_db_handle* db,
+	isc_tr_handle* tr, isc_blob_handle* blob, ISC_QUAD* id, short bpblength, char* bpb)
+{
+	TraceCall call(IBPP::toCreateBlob, blob);
+	return call.Done(status, (*gds.m_create_blob2)(status, db, tr, blob, id,
+		bpblength, bpb));
+}
+
+static ISC_STATUS ISC_EXPORT traceGetSegment(ISC_STATUS* status, isc_blob_handle* blob,
+	unsigned short* actual, unsigned short length, char* buffer)
+{
+	TraceCall call(IBPP::toGetSegment, blob);
+	ISC_STATUS result = (*gds.m_get_segment)(status, blob, actual, length, buffer);
+	if (actual != 0) call.Bytes(*actual);
+	return call.Done(status, result);
+}
+
+static ISC_STATUS ISC_EXPORT tracePutSegment(ISC_STATUS* status, isc_blob_handle* blob,
+	unsigned short length, char* buffer)
+{
+	TraceCall call(IBPP::toPutSegment, blob, std::string(), length);
+	return call.Done(status, (*gds.m_put_segment)(status, blob, length, buffer));
+}
+
+static ISC_STATUS ISC_EXPORT traceCloseBlob(ISC_STATUS* status, isc_blob_handle* blob)
+{
+	TraceCall call(IBPP::toCloseBlob, blob);
+	return call.Done(status, (*gds.m_close_blob)(status, blob));
+}
+
+static ISC_STATUS ISC_EXPORT traceCancelBlob(ISC_STATUS* status, isc_blob_handle* blob)
+{
+	TraceCall call(IBPP::toCancelBlob, blob);
+	return call.Done(status, (*gds.m_cancel_blob)(status, blob));
+}
+
+static ISC_STATUS ISC_EXPORT traceBlobInfo(ISC_STATUS* status, isc_blob_handle* blob,
+	short itemslength, char* items, short length, char* buffer)
+{
+	TraceCall call(IBPP::toBlobInfo, blob, std::string(), length);
+	return call.Done(status, (*gds.m_blob_info)(status, blob, itemslength, items,
+		length, buffer));
+}
+
+static ISC_STATUS ISC_EXPORT traceArrayLookupBounds(ISC_STATUS* status,
+	isc_db_handle* db, isc_tr_handle* tr, char* table, char* column,
+	ISC_ARRAY_DESC* desc)
+{
+	TraceCall call(IBPP::toArrayLookupBounds, db);
+	return call.Done(status, (*gds.m_array_lookup_bounds)(status, db, tr, table,
+		column, desc));
+}
+
+static ISC_STATUS ISC_EXPORT traceArrayGetSlice(ISC_STATUS* status, isc_db_handle* db,
+	isc_tr_handle* tr, ISC_QUAD* id, ISC_ARRAY_DESC* desc, void* slice,
+	ISC_LONG* length)
+{
+	TraceCall call(IBPP::toArrayGetSlice, db, std::string(), *length);
+	return call.Done(status, (*gds.m_array_get_slice)(status, db, tr, id, desc,
+		slice, length));
+}
+
+static ISC_STATUS ISC_EXPORT traceArrayPutSlice(ISC_STATUS* status, isc_db_handle* db,
+	isc_tr_handle* tr, ISC_QUAD* id, ISC_ARRAY_DESC* desc, void* slice,
+	ISC_LONG* length)
+{
+	TraceCall call(IBPP::toArrayPutSlice, db, std::string(), *length);
+	return call.Done(status, (*gds.m_array_put_slice)(status, db, tr, id, desc,
+		slice, length));
+}
+
+//	(((((((( EVENTS AND SERVICES ))))))))
+
+static ISC_STATUS ISC_EXPORT traceQueEvents(ISC_STATUS* status, isc_db_handle* db,
+	ISC_LONG* id, short length, char* events, isc_callback callback, void* arg)
+{
+	TraceCall call(IBPP::toQueEvents, db);
+	return call.Done(status, (*gds.m_que_events)(status, db, id, length, events,
+		callback, arg));
+}
+
+static ISC_STATUS ISC_EXPORT traceCancelEvents(ISC_STATUS* status, isc_db_handle* db,
+	ISC_LONG* id)
+{
+	TraceCall call(IBPP::toCancelEvents, db);
+	return call.Done(status, (*gds.m_cancel_events)(status, db, id));
+}
+
+static ISC_STATUS ISC_EXPORT traceServiceAttach(ISC_STATUS* status, unsigned short length,
+	char* name, isc_svc_handle* svc, unsigned short spblength, char* spb)
+{
+	TraceCall call(IBPP::toServiceAttach, svc);
+	return call.Done(status, (*gds.m_service_attach)(status, length, name, svc,
+		spblength, spb));
+}
+
+static ISC_STATUS ISC_EXPORT traceServiceDetach(ISC_STATUS* status, isc_svc_handle* svc)
+{
+	TraceCall call(IBPP::toServiceDetach, svc);
+	return call.Done(status, (*gds.m_service_detach)(status, svc));
+}
+
+static ISC_STATUS ISC_EXPORT traceServiceStart(ISC_STATUS* status, isc_svc_handle* svc,
+	isc_resv_handle* reserved, unsigned short length, char* spb)
+{
+	TraceCall call(IBPP::toServiceStart, svc);
+	return call.Done(status, (*gds.m_service_start)(status, svc, reserved, length, spb));
+}
+
+static ISC_STATUS ISC_EXPORT traceServiceQuery(ISC_STATUS* status, isc_svc_handle* svc,
+	isc_resv_handle* reserved, unsigned short sendlength, char* send,
+	unsigned short requestlength, char* request, unsigned short length, char* buffer)
+{
+	TraceCall call(IBPP::toServiceQuery, svc, std::string(), length);
+	return call.Done(status, (*gds.m_service_query)(status, svc, reserved,
+		sendlength, send, requestlength, request, length, buffer));
+}
+
+//	(((((((( THE TRACED TABLE ))))))))
+
+static void LoadTraced()
+{
+	// Local helpers of the library are not traced
+	traced.mGDSVersion = gds.mGDSVersion;
+	traced.m_vax_integer = gds.m_vax_integer;
+	traced.m_sqlcode = gds.m_sqlcode;
+	traced.m_sql_interprete = gds.m_sql_interprete;
+	traced.m_interprete = gds.m_interprete;
+
+	traced.m_create_database = traceCreateDatabase;
+	traced.m_attach_database = traceAttachDatabase;
+	traced.m_detach_database = traceDetachDatabase;
+	traced.m_drop_database = traceDropDatabase;
+	traced.m_database_info = traceDatabaseInfo;
+	traced.m_dsql_execute_immediate = traceExecuteImmediate;
+	traced.m_open_blob2 = traceOpenBlob;
+	traced.m_create_blob2 = traceCreateBlob;
+	traced.m_close_blob = traceCloseBlob;
+	traced.m_cancel_blob = traceCancelBlob;
+	traced.m_get_segment = traceGetSegment;
+	traced.m_put_segment = tracePutSegment;
+	traced.m_blob_info = traceBlobInfo;
+	traced.m_array_lookup_bounds = traceArrayLookupBounds;
+	traced.m_array_get_slice = traceArrayGetSlice;
+	traced.m_array_put_slice = traceArrayPutSlice;
+	traced.m_que_events = traceQueEvents;
+	traced.m_cancel_events = traceCancelEvents;
+	traced.m_start_multiple = traceStartMultiple;
+	traced.m_commit_transaction = traceCommit;
+	traced.m_commit_retaining = traceCommitRetaining;
+	traced.m_rollback_transaction = traceRollback;
+	traced.m_rollback_retaining = traceRollbackRetaining;
+	traced.m_dsql_allocate_statement = traceAllocateStatement;
+	traced.m_dsql_describe = traceDescribe;
+	traced.m_dsql_describe_bind = traceDescribeBind;
+	traced.m_dsql_prepare = tracePrepare;
+	traced.m_dsql_execute = traceExecute;
+	traced.m_dsql_execute2 = traceExecute2;
+	traced.m_dsql_fetch = traceFetch;
+	traced.m_dsql_free_statement = traceFreeStatement;
+	traced.m_dsql_set_cursor_name = traceSetCursorName;
+	traced.m_dsql_sql_info = traceStatementInfo;
+	traced.m_service_attach = traceServiceAttach;
+	traced.m_service_detach = traceServiceDetach;
+	traced.m_service_start = traceServiceStart;
+	traced.m_service_query = traceServiceQuery;
+}
+
+void IBPP::SetTraceObserver(IBPP::ITraceObserver* newobserver)
+{
+	(void)gds.Call();			// Triggers the initialization, if needed
+	std::call_once(tracedReady, LoadTraced);
+
+	// The observer is set before the table which calls it, and the table
+	// goes back to gds before the observer is removed
+	std::lock_guard<std::mutex> guard(observerLock);
+	if (newobserver != 0)
+	{
+		observer.store(newobserver);
+		gds.mTable.store(&traced, std::memory_order_release);
+	}
+	else
+	{
+		gds.mTable.store(&gds, std::memory_order_release);
+		observer.store(0);
+	}
+
+	// Once the calls which may use the previous observer are done, it can go
+	const unsigned previous = epoch++;
+	while (inFlight[previous & 1].load() != 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if (newobserver == 0)
+	{
+		std::lock_guard<std::mutex> guard(statementsLock);
+		statements.clear();
+	}
+}
+
+//
+//	EOF
+//
@@ -35,16 +35,28 @@
 #include "_ibpp.cpp"
 #include "_dpb.cpp"
 #include "_ibs.cpp"
+#include "_prefetch.cpp"
+#include "_perf.cpp"
+#include "_trace.cpp"
 #include "_rb.cpp"
+#include "_rowpool.cpp"
 #include "_spb.cpp"
 #include "_tpb.cpp"
 
 #include "array.cpp"
 #include "blob.cpp"
+#include "columnbatch.cpp"
 #include "database.cpp"
+#include "databasepool.cpp"
 #include "date.cpp"
 #include "dbkey.cpp"
 #include "events.cpp"
+#include "executor.cpp"
+#include "parallelscan.cpp"
+#include "bulkloader.cpp"
+#include "retry.cpp"
+#include "querystats.cpp"
+#include "plan.cpp"
 #include "exception.cpp"
 #include "row.cpp"
 #include "service.cpp"
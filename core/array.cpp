@@ -45,6 +45,7 @@ using namespace ibpp_internals;
 
 void ArrayImpl::Describe(const std::string& table, const std::string& column)
 {
+	THREADCHECK(mDatabase);
 	//if (mIdAssigned)
 	//	throw LogicExceptionImpl("Array::Lookup", _("Array already in use."));
 	if (mDatabase == 0)
@@ -192,6 +193,7 @@ We have no idea if this is fixed or not in Interbase 6.5 though.
 
 void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 {
+	THREADCHECK(mDatabase);
 	if (! mIdAssigned)
 		throw LogicExceptionImpl("Array::ReadTo", _("Array Id not read from column."));
 	if (! mDescribed)
@@ -542,6 +544,7 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 
 void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
 {
+	THREADCHECK(mDatabase);
 	if (! mDescribed)
 		throw LogicExceptionImpl("Array::WriteFrom", _("Array description not set."));
 	if (mDatabase == 0)
@@ -923,8 +926,7 @@ void ArrayImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
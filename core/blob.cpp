@@ -43,6 +43,7 @@ using namespace ibpp_internals;
 
 void BlobImpl::Open()
 {
+	THREADCHECK(mDatabase);
 	if (mHandle != 0)
 		throw LogicExceptionImpl("Blob::Open", _("Blob already opened."));
 	if (mDatabase == 0)
@@ -62,6 +63,7 @@ void BlobImpl::Open()
 
 void BlobImpl::Create()
 {
+	THREADCHECK(mDatabase);
 	if (mHandle != 0)
 		throw LogicExceptionImpl("Blob::Create", _("Blob already opened."));
 	if (mDatabase == 0)
@@ -81,6 +83,7 @@ void BlobImpl::Create()
 
 void BlobImpl::Close()
 {
+	THREADCHECK(mDatabase);
 	if (mHandle == 0) return;	// Not opened anyway
 
 	IBS status;
@@ -92,6 +95,7 @@ void BlobImpl::Close()
 
 void BlobImpl::Cancel()
 {
+	THREADCHECK(mDatabase);
 	if (mHandle == 0) return;	// Not opened anyway
 
 	if (! mWriteMode)
@@ -107,6 +111,7 @@ void BlobImpl::Cancel()
 
 int BlobImpl::Read(void* buffer, int size)
 {
+	THREADCHECK(mDatabase);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Blob::Read", _("The Blob is not opened"));
 	if (mWriteMode)
@@ -126,6 +131,7 @@ int BlobImpl::Read(void* buffer, int size)
 
 void BlobImpl::Write(const void* buffer, int size)
 {
+	THREADCHECK(mDatabase);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Blob::Write", _("The Blob is not opened"));
 	if (! mWriteMode)
@@ -142,6 +148,7 @@ void BlobImpl::Write(const void* buffer, int size)
 
 void BlobImpl::Info(int* Size, int* Largest, int* Segments)
 {
+	THREADCHECK(mDatabase);
 	char items[] = {isc_info_blob_total_length,
 					isc_info_blob_max_segment,
 					isc_info_blob_num_segments};
@@ -163,6 +170,7 @@ void BlobImpl::Info(int* Size, int* Largest, int* Segments)
 
 void BlobImpl::Save(const std::string& data)
 {
+	THREADCHECK(mDatabase);
 	if (mHandle != 0)
 		throw LogicExceptionImpl("Blob::Save", _("Blob already opened."));
 	if (mDatabase == 0)
@@ -203,6 +211,7 @@ void BlobImpl::Save(const std::string& data)
 
 void BlobImpl::Load(std::string& data)
 {
+	THREADCHECK(mDatabase);
 	if (mHandle != 0)
 		throw LogicExceptionImpl("Blob::Load", _("Blob already opened."));
 	if (mDatabase == 0)
@@ -273,8 +282,7 @@ void BlobImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
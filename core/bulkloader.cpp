@@ -0,0 +1,441 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, BulkLoader class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <algorithm>
+#include <random>
+
+using namespace ibpp_internals;
+
+//	Rows run by each ExecuteBatch(), runs of a row hitting lock conflicts
+const int BulkLoaderImpl::TAKEROWS = 256;
+const int BulkLoaderImpl::MAXRETRIES = 10;
+const int BulkLoaderImpl::MAXERRORS = 1000;
+
+//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
+
+IBPP::Row BulkLoaderImpl::NewRow()
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	if (mShape == 0)
+		throw LogicExceptionImpl("BulkLoader::NewRow", _("The loader is closed."));
+	return new RowImpl(*mShape);
+}
+
+void BulkLoaderImpl::Add(const IBPP::Row& row)
+{
+	RowImpl* src = dynamic_cast<RowImpl*>(row.intf());
+	if (src == 0)
+		throw LogicExceptionImpl("BulkLoader::Add", _("No Row given."));
+	if (src->MissingValues())
+		throw LogicExceptionImpl("BulkLoader::Add", _("All parameters must be specified."));
+
+	// The copy is made before locking, the producers only wait on each other
+	// to queue it
+	Queued queued;
+	queued.row = new RowImpl(*src);
+	queued.row->AddRef();
+	queued.added = Clock::now();
+	const int bytes = queued.row->BufferSize();
+
+	std::unique_lock<std::mutex> guard(mLock);
+	while (! mError && ! mStopping && mQueuedBytes > 0 && mQueuedBytes + bytes > mBudget)
+		mDone.wait(guard);
+	if (mError || mStopping || src->Self()->sqld != mShape->Self()->sqld
+		|| bytes != mShape->BufferSize())
+	{
+		std::exception_ptr error = mError;
+		bool closed = mStopping;
+		guard.unlock();
+		queued.row->Release();
+		if (error) std::rethrow_exception(error);
+		if (closed)
+			throw LogicExceptionImpl("BulkLoader::Add", _("The loader is closed."));
+		throw LogicExceptionImpl("BulkLoader::Add", _("The Row does not come from NewRow()."));
+	}
+
+	// The row goes to the partition with the shortest queue
+	int p = 0;
+	for (int i = 1; i < mParts; i++)
+		if (mPartitions[i].queue.size() < mPartitions[p].queue.size()) p = i;
+	queued.number = (int)mStats.added++;
+	mPartitions[p].queue.push_back(queued);
+	mQueuedBytes += bytes;
+	mPartitions[p].work.notify_one();
+}
+
+void BulkLoaderImpl::Flush()
+{
+	std::unique_lock<std::mutex> guard(mLock);
+	++mFlushing;
+	for (int i = 0; i < (int)mPartitions.size(); i++)
+		mPartitions[i].work.notify_one();
+	while (! mError && ! Flushed())
+		mDone.wait(guard);
+	--mFlushing;
+	if (mError) std::rethrow_exception(mError);
+}
+
+void BulkLoaderImpl::Close()
+{
+	std::exception_ptr error;
+	try { Flush(); }
+		catch (...) { error = std::current_exception(); }
+	Stop();
+	if (error) std::rethrow_exception(error);
+}
+
+void BulkLoaderImpl::Statistics(IBPP::BulkLoaderStats& stats)
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	stats = mStats;
+	stats.seconds = Ms(mStart, Clock::now()) / 1000;
+	stats.rowsPerSecond = stats.seconds > 0 ? stats.loaded / stats.seconds : 0;
+	stats.avgBatchMs = mBatches > 0 ? mBatchMs / mBatches : 0;
+	stats.avgLatencyMs = stats.loaded > 0 ? mLatencyMs / stats.loaded : 0;
+}
+
+void BulkLoaderImpl::Errors(std::vector<IBPP::BatchError>& errors)
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	errors = mErrors;
+}
+
+IBPP::IBulkLoader* BulkLoaderImpl::AddRef()
+{
+	ASSERTION(mRefCount >= 0);
+	++mRefCount;
+	return this;
+}
+
+void BulkLoaderImpl::Release()
+{
+	// Release cannot throw, except in DEBUG builds on assertion
+	ASSERTION(mRefCount >= 0);
+	try { if (--mRefCount <= 0) delete this; }
+		catch (...) { }
+}
+
+//	(((((((( OBJECT INTERNAL METHODS ))))))))
+
+void BulkLoaderImpl::Load(int p)
+{
+	// Thread of partition p. Its attachment, transaction and statement are
+	// its own, only its queue is shared with the producers.
+	Part& part = mPartitions[p];
+	std::vector<Queued> rows;		// Taken from the queue
+	Committing committing;
+	committing.rows = 0;
+	committing.addedMs = 0;
+	committing.oldest = committing.due = Clock::now();
+	try
+	{
+		IBPP::Database db = dynamic_cast<DatabaseImpl*>(mDatabase.intf())->Clone();
+		IBPP::Transaction tr = IBPP::TransactionFactory(db, IBPP::amWrite,
+			IBPP::ilReadCommitted, IBPP::lrNoWait);
+		tr->Start();
+		IBPP::Statement st = IBPP::StatementFactory(db, tr, mSql);
+		StatementImpl* stimpl = dynamic_cast<StatementImpl*>(st.intf());
+		if (stimpl->ParametersRow() == 0)
+			throw LogicExceptionImpl("BulkLoader", _("The statement does not take parameters."));
+
+		{
+			std::lock_guard<std::mutex> guard(mLock);
+			if (mShape == 0)
+			{
+				mShape = new RowImpl(*stimpl->ParametersRow());
+				mShape->AddRef();
+				mShape->ClearUpdated();
+			}
+			part.ready = true;
+		}
+		mDone.notify_all();
+
+		for (;;)
+		{
+			bool flush = false;
+			{
+				std::unique_lock<std::mutex> guard(mLock);
+				while (part.queue.empty())
+				{
+					if (part.pending > 0 && (mFlushing > 0 || mStopping
+						|| Clock::now() >= committing.due))
+					{
+						flush = true;
+						break;
+					}
+					if (mStopping) break;
+					if (part.pending > 0) part.work.wait_until(guard, committing.due);
+					else part.work.wait(guard);
+				}
+				if (part.queue.empty() && ! flush) break;	// Stopping, all committed
+
+				// No more than what the next commit takes
+				const int take = std::max(1, std::min(TAKEROWS, mCommitRows - part.pending));
+				while (! part.queue.empty() && (int)rows.size() < take)
+				{
+					mQueuedBytes -= part.queue.front().row->BufferSize();
+					rows.push_back(part.queue.front());
+					part.queue.pop_front();
+				}
+				if (part.pending == 0 && ! rows.empty())
+					committing.due = Clock::now() + std::chrono::milliseconds(mCommitMs);
+				part.pending += (int)rows.size();
+			}
+
+			if (! rows.empty())
+			{
+				mDone.notify_all();		// Room made in the budget
+				Run(p, tr, stimpl, rows, committing);
+			}
+			if (flush || part.pending >= mCommitRows || Clock::now() >= committing.due)
+				Commit(p, tr, committing);
+		}
+
+		st->Close();
+		tr->Commit();
+		db->Disconnect();
+	}
+	catch (...)
+	{
+		// The rows not committed yet are lost
+		std::lock_guard<std::mutex> guard(mLock);
+		if (! mError) mError = std::current_exception();
+		mStats.failed += committing.rows + (int64_t)rows.size() + (int64_t)part.queue.size();
+		for (size_t i = 0; i < rows.size(); i++)
+			rows[i].row->Release();
+		for (size_t i = 0; i < part.queue.size(); i++)
+		{
+			mQueuedBytes -= part.queue[i].row->BufferSize();
+			part.queue[i].row->Release();
+		}
+		part.queue.clear();
+		part.pending = 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		part.done = true;
+	}
+	mDone.notify_all();
+}
+
+void BulkLoaderImpl::Run(int p, IBPP::Transaction& tr, StatementImpl* st,
+	std::vector<Queued>& rows, Committing& committing)
+{
+	// Runs the rows as one batch. Those hitting a lock conflict are run again
+	// after a pause, doubled on each run, the others in error are given up.
+	// The rows inserted so far are committed before pausing, so that the
+	// transaction does not keep its locks meanwhile.
+	enum {rsInserted, rsFailed, rsAgain};
+	std::vector<int> affected;
+	std::vector<IBPP::BatchError> errors;
+	std::vector<Queued> again;
+	int pause = 10;
+	static thread_local std::minstd_rand random(
+		(unsigned)std::hash<std::thread::id>()(std::this_thread::get_id()));
+	std::uniform_real_distribution<double> share(0.0, 0.5);
+
+	for (int run = 1; ; run++)
+	{
+		for (size_t i = 0; i < rows.size(); i++)
+			st->AddBatch(rows[i].row);
+		Clock::time_point start = Clock::now();
+		st->ExecuteBatch(affected, errors, 0);
+		double ms = Ms(start, Clock::now());
+
+		std::vector<char> state(rows.size(), (char)rsInserted);
+		again.clear();
+		{
+			std::lock_guard<std::mutex> guard(mLock);
+			for (size_t e = 0; e < errors.size(); e++)
+			{
+				IBPP::BatchError& error = errors[e];
+				const Queued& queued = rows[error.row];
+				if (lockConflict(error.enginecode) && run < MAXRETRIES)
+				{
+					state[error.row] = rsAgain;
+					again.push_back(queued);
+					continue;
+				}
+				state[error.row] = rsFailed;
+				++mStats.failed;
+				if ((int)mErrors.size() < MAXERRORS)
+				{
+					error.row = queued.number;
+					mErrors.push_back(error);
+				}
+			}
+			mStats.retried += (int64_t)again.size();
+			++mBatches;
+			mBatchMs += ms;
+			if (ms > mStats.maxBatchMs) mStats.maxBatchMs = ms;
+		}
+
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			if (state[i] == rsInserted)
+			{
+				if (committing.rows == 0 || rows[i].added < committing.oldest)
+					committing.oldest = rows[i].added;
+				++committing.rows;
+				committing.addedMs += Ms(mStart, rows[i].added);
+			}
+			if (state[i] != rsAgain) rows[i].row->Release();
+		}
+		rows.swap(again);
+		if (rows.empty()) break;
+
+		if (committing.rows > 0)
+		{
+			Commit(p, tr, committing);
+			std::lock_guard<std::mutex> guard(mLock);
+			mPartitions[p].pending = (int)rows.size();
+			committing.due = Clock::now() + std::chrono::milliseconds(mCommitMs);
+		}
+
+		// The jitter keeps the loaders which conflicted from running again
+		// all at the same time, as IBPP::Retry() does
+		std::this_thread::sleep_for(std::chrono::milliseconds(
+			pause - (int)(pause * share(random))));
+		pause = std::min(pause * 2, 1000);
+	}
+}
+
+void BulkLoaderImpl::Commit(int p, IBPP::Transaction& tr, Committing& committing)
+{
+	tr->Commit();
+	Clock::time_point now = Clock::now();
+	tr->Start();
+
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		++mStats.commits;
+		if (committing.rows > 0)
+		{
+			mStats.loaded += committing.rows;
+			mLatencyMs += committing.rows * Ms(mStart, now) - committing.addedMs;
+			double latest = Ms(committing.oldest, now);
+			if (latest > mStats.maxLatencyMs) mStats.maxLatencyMs = latest;
+		}
+		mPartitions[p].pending = 0;
+	}
+	committing.rows = 0;
+	committing.addedMs = 0;
+	mDone.notify_all();
+}
+
+bool BulkLoaderImpl::Flushed()
+{
+	// Called with mLock held
+	for (int i = 0; i < (int)mPartitions.size(); i++)
+		if (! mPartitions[i].queue.empty() || mPartitions[i].pending > 0)
+			return false;
+	return true;
+}
+
+void BulkLoaderImpl::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		mStopping = true;
+		for (int i = 0; i < (int)mPartitions.size(); i++)
+			mPartitions[i].work.notify_one();
+	}
+	mDone.notify_all();		// Add() waiting for room
+
+	// Each partition loads and commits its queue, then closes its attachment
+	for (unsigned i = 0; i < mThreads.size(); i++)
+		mThreads[i].join();
+	mThreads.clear();
+
+	if (mShape != 0) { mShape->Release(); mShape = 0; }
+}
+
+double BulkLoaderImpl::Ms(Clock::time_point from, Clock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+BulkLoaderImpl::BulkLoaderImpl(IBPP::Database db, const std::string& sql,
+	int parts, int commitRows, int commitMs, int64_t memoryBudget)
+	: mRefCount(0), mDatabase(db), mSql(sql), mParts(parts),
+	mCommitRows(commitRows), mCommitMs(commitMs), mBudget(memoryBudget),
+	mStart(Clock::now()), mShape(0), mQueuedBytes(0), mFlushing(0),
+	mStopping(false), mBatchMs(0), mBatches(0), mLatencyMs(0)
+{
+	if (db.intf() == 0)
+		throw LogicExceptionImpl("BulkLoader", _("No Database given."));
+	if (sql.empty())
+		throw LogicExceptionImpl("BulkLoader", _("No statement given."));
+	if (parts < 1)
+		throw LogicExceptionImpl("BulkLoader", _("Invalid count of attachments %d."), parts);
+	if (commitRows < 1 || commitMs < 1 || memoryBudget < 1)
+		throw LogicExceptionImpl("BulkLoader", _("Invalid commit or memory limits."));
+
+	for (int i = 0; i < parts; i++)
+		mPartitions.emplace_back();
+
+	try
+	{
+		for (int i = 0; i < parts; i++)
+			mThreads.push_back(std::thread(&BulkLoaderImpl::Load, this, i));
+
+		// Returns once all the statements are prepared, or one failed
+		std::unique_lock<std::mutex> guard(mLock);
+		for (int i = 0; i < parts && ! mError; )
+			if (mPartitions[i].ready || mPartitions[i].done) i++;
+			else mDone.wait(guard);
+		if (mError) std::rethrow_exception(mError);
+	}
+	catch (...)
+	{
+		Stop();
+		throw;
+	}
+}
+
+BulkLoaderImpl::~BulkLoaderImpl()
+{
+	try { Stop(); }
+		catch (...) { }
+}
+
+//
+//	EOF
+//
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, ColumnBatch class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+using namespace ibpp_internals;
+
+//	Public implementation
+
+IBPP::BCT IBPP::ColumnBatch::Type(int col) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::Type", _("Column index out of range."));
+
+	return mColumns[col-1].type;
+}
+
+int IBPP::ColumnBatch::Scale(int col) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::Scale", _("Column index out of range."));
+
+	return mColumns[col-1].scale;
+}
+
+bool IBPP::ColumnBatch::IsNull(int col, int row) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::IsNull", _("Column index out of range."));
+	if (row < 0 || row >= mRows)
+		throw LogicExceptionImpl("ColumnBatch::IsNull", _("Row index out of range."));
+
+	return (mColumns[col-1].nulls[row / 8] & (1 << (row % 8))) != 0;
+}
+
+const unsigned char* IBPP::ColumnBatch::Nulls(int col) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::Nulls", _("Column index out of range."));
+
+	const Column& c = mColumns[col-1];
+	return c.nulls.empty() ? 0 : &c.nulls[0];
+}
+
+const void* IBPP::ColumnBatch::Values(int col) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::Values", _("Column index out of range."));
+
+	const Column& c = mColumns[col-1];
+	return c.values.empty() ? 0 : &c.values[0];
+}
+
+const int32_t* IBPP::ColumnBatch::Offsets(int col) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::Offsets", _("Column index out of range."));
+
+	const Column& c = mColumns[col-1];
+	if (c.type != bcString)
+		throw LogicExceptionImpl("ColumnBatch::Offsets", _("Column is not a string column."));
+
+	return c.offsets.empty() ? 0 : &c.offsets[0];
+}
+
+std::string IBPP::ColumnBatch::String(int col, int row) const
+{
+	if (col < 1 || col > (int)mColumns.size())
+		throw LogicExceptionImpl("ColumnBatch::String", _("Column index out of range."));
+	if (row < 0 || row >= mRows)
+		throw LogicExceptionImpl("ColumnBatch::String", _("Row index out of range."));
+
+	const Column& c = mColumns[col-1];
+	if (c.type != bcString)
+		throw LogicExceptionImpl("ColumnBatch::String", _("Column is not a string column."));
+
+	const int32_t start = c.offsets[row];
+	return std::string(c.values.begin() + start, c.values.begin() + c.offsets[row+1]);
+}
+
+void IBPP::ColumnBatch::Clear()
+{
+	mColumns.clear();
+	mRows = 0;
+}
+
+//
+//	EOF
+//
@@ -45,6 +45,7 @@ using namespace ibpp_internals;
 
 void DatabaseImpl::Create(int dialect)
 {
+	THREADCHECK(this);
 	if (mHandle != 0)
 		throw LogicExceptionImpl("Database::Create", _("Database is already connected."));
 	if (mDatabaseName.empty())
@@ -79,6 +80,7 @@ void DatabaseImpl::Create(int dialect)
 
 void DatabaseImpl::Connect()
 {
+	THREADCHECK(this);
 	if (mHandle != 0) return;	// Already connected
 
 	if (mDatabaseName.empty())
@@ -184,6 +186,9 @@ void DatabaseImpl::Inactivate()
 	while (mStatements.size() > 0)
 		mStatements.back()->DetachDatabaseImpl();
 
+	// Drop the prepared statements they may have left in the cache
+	ClearStatementCache();
+
 	// Let's detach from all Transactions
 	while (mTransactions.size() > 0)
 		mTransactions.back()->DetachDatabaseImpl(this);
@@ -195,6 +200,7 @@ void DatabaseImpl::Inactivate()
 
 void DatabaseImpl::Disconnect()
 {
+	THREADCHECK(this);
 	if (mHandle == 0) return;	// Not connected anyway
 
 	// Put the connection to rest
@@ -207,12 +213,16 @@ void DatabaseImpl::Disconnect()
     // Should we throw, set mHandle to 0 first, because Disconnect() may
 	// be called from Database destructor (keeps the object coherent).
 	mHandle = 0;
+	mRelationNames.clear();
+	mRelationRows.clear();
+	mRelationRowsRead = false;
     if (status.Errors())
 		throw SQLExceptionImpl(status, "Database::Disconnect", _("isc_detach_database failed"));
 }
 
 void DatabaseImpl::Drop()
 {
+	THREADCHECK(this);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Database::Drop", _("Database must be connected."));
 
@@ -225,12 +235,16 @@ void DatabaseImpl::Drop()
     	throw SQLExceptionImpl(vector, "Database::Drop", _("isc_drop_database failed"));
 
     mHandle = 0;
+	mRelationNames.clear();
+	mRelationRows.clear();
+	mRelationRowsRead = false;
 }
 
 void DatabaseImpl::Info(int* ODSMajor, int* ODSMinor,
 	int* PageSize, int* Pages, int* Buffers, int* Sweep,
 	bool* Sync, bool* Reserve)
 {
+	THREADCHECK(this);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Database::Info", _("Database is not connected."));
 
@@ -266,6 +280,7 @@ void DatabaseImpl::Info(int* ODSMajor, int* ODSMinor,
 
 void DatabaseImpl::Statistics(int* Fetches, int* Marks, int* Reads, int* Writes)
 {
+	THREADCHECK(this);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Database::Statistics", _("Database is not connected."));
 
@@ -292,6 +307,7 @@ void DatabaseImpl::Statistics(int* Fetches, int* Marks, int* Reads, int* Writes)
 void DatabaseImpl::Counts(int* Insert, int* Update, int* Delete, 
 	int* ReadIdx, int* ReadSeq)
 {
+	THREADCHECK(this);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Database::Counts", _("Database is not connected."));
 
@@ -317,8 +333,100 @@ void DatabaseImpl::Counts(int* Insert, int* Update, int* Delete,
 	if (ReadSeq != 0) *ReadSeq = result.GetCountValue(isc_info_read_seq_count);
 }
 
+void DatabaseImpl::Statistics(IBPP::DatabaseStats& stats)
+{
+	THREADCHECK(this);
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Database::Statistics", _("Database is not connected."));
+
+	char items[] = {isc_info_fetches,
+					isc_info_marks,
+					isc_info_reads,
+					isc_info_writes,
+					isc_info_page_size,
+					isc_info_allocation,
+					isc_info_num_buffers,
+					isc_info_current_memory,
+					isc_info_max_memory,
+					isc_info_insert_count,
+					isc_info_update_count,
+					isc_info_delete_count,
+					isc_info_read_idx_count,
+					isc_info_read_seq_count,
+					isc_info_end};
+	// The names of the relations met for the first time are read, then the
+	// counters are taken again : the reads of that query are then not left
+	// to the next snapshot, and a delta only measures the work in between.
+	for (int pass = 0; ; pass++)
+	{
+		IBS status;
+		RB result(32000);
+
+		(*gds.Call()->m_database_info)(status.Self(), &mHandle, sizeof(items), items,
+			result.Size(), result.Self());
+		if (status.Errors())
+			throw SQLExceptionImpl(status, "Database::Statistics", _("isc_database_info failed"));
+
+		// All the items are read in a single pass over the reply. Those of the
+		// relations are arrays of 6 bytes : the relation id (2) and the count (4).
+		stats = IBPP::DatabaseStats();
+		bool unknown = false;
+		const char* p = result.Self();
+		const char* end = p + result.Size();
+		while (p + 3 <= end && *p != isc_info_end)
+		{
+			if (*p == isc_info_truncated)
+				throw LogicExceptionImpl("Database::Statistics",
+					_("The counters of the relations do not fit in the reply."));
+			const char item = *p;
+			const int len = (int)infoInteger(p + 1, 2) & 0xFFFF;
+			p += 3;
+			if (p + len > end) break;
+			const int64_t value = len <= 8 ? infoInteger(p, len) : 0;
+			int64_t IBPP::RelationStats::* counter = 0;
+			switch (item)
+			{
+				case isc_info_fetches :			stats.fetches = value; break;
+				case isc_info_marks :			stats.marks = value; break;
+				case isc_info_reads :			stats.reads = value; break;
+				case isc_info_writes :			stats.writes = value; break;
+				case isc_info_page_size :		stats.pageSize = (int)value; break;
+				case isc_info_allocation :		stats.pages = (int)value; break;
+				case isc_info_num_buffers :		stats.buffers = (int)value; break;
+				case isc_info_current_memory :	stats.currentMemory = value; break;
+				case isc_info_max_memory :		stats.maxMemory = value; break;
+				case isc_info_insert_count :	counter = &IBPP::RelationStats::inserts; break;
+				case isc_info_update_count :	counter = &IBPP::RelationStats::updates; break;
+				case isc_info_delete_count :	counter = &IBPP::RelationStats::deletes; break;
+				case isc_info_read_idx_count :	counter = &IBPP::RelationStats::readIdx; break;
+				case isc_info_read_seq_count :	counter = &IBPP::RelationStats::readSeq; break;
+			}
+			if (counter != 0)
+			{
+				for (int i = 0; i + 6 <= len; i += 6)
+				{
+					const int id = (int)infoInteger(p + i, 2) & 0xFFFF;
+					IBPP::RelationStats& relation = stats.relations[id];
+					relation.*counter = infoInteger(p + i + 2, 4);
+					if (relation.name.empty())
+					{
+						std::map<int, std::string>::const_iterator it = mRelationNames.find(id);
+						if (it != mRelationNames.end()) relation.name = it->second;
+						else unknown = true;
+					}
+				}
+			}
+			p += len;
+		}
+
+		if (! unknown || pass > 0) break;
+		RelationNames();	// All at once
+	}
+}
+
 void DatabaseImpl::Users(std::vector<std::string>& users)
 {
+	THREADCHECK(this);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Database::Users", _("Database is not connected."));
 
@@ -349,6 +457,23 @@ void DatabaseImpl::Users(std::vector<std::string>& users)
 	return;
 }
 
+void DatabaseImpl::SetStatementCacheSize(int size)
+{
+	if (size < 0)
+		throw LogicExceptionImpl("Database::SetStatementCacheSize",
+			_("Invalid cache size %d."), size);
+
+	mCacheSize = size;
+	while ((int)mCache.size() > mCacheSize) CacheEvict();
+}
+
+void DatabaseImpl::StatementCacheStatistics(int* Hits, int* Misses, int* Evictions)
+{
+	if (Hits != 0) *Hits = mCacheHits;
+	if (Misses != 0) *Misses = mCacheMisses;
+	if (Evictions != 0) *Evictions = mCacheEvictions;
+}
+
 IBPP::IDatabase* DatabaseImpl::AddRef()
 {
 	ASSERTION(mRefCount >= 0);
@@ -360,13 +485,99 @@ void DatabaseImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
 //	(((((((( OBJECT INTERNAL METHODS ))))))))
 
+void DatabaseImpl::RelationNames()
+{
+	IBPP::Transaction tr = IBPP::TransactionFactory(this, IBPP::amRead,
+		IBPP::ilReadCommitted);
+	tr->Start();
+	IBPP::Statement st = IBPP::StatementFactory(this, tr,
+		"select RDB$RELATION_ID, RDB$RELATION_NAME from RDB$RELATIONS");
+	st->Execute();
+	while (st->Fetch())
+	{
+		int16_t id;
+		std::string name;
+		st->Get(1, id);
+		st->Get(2, name);
+		name.erase(name.find_last_not_of(' ') + 1);
+		mRelationNames[id] = name;
+	}
+	st->Close();
+	tr->Commit();
+}
+
+IBPP::Database DatabaseImpl::Clone()
+{
+	// For the helpers which work through several threads, each with its own
+	// attachment (ParallelScan, BulkLoader)
+	IBPP::Database db = new DatabaseImpl(mServerName, mDatabaseName,
+		mUserName, mUserPassword, mRoleName, mCharSet, "");
+	db->Connect();
+	return db;
+}
+
+int64_t DatabaseImpl::RelationRows(const std::string& relation)
+{
+	// Rows of a relation as told by the selectivity of its most selective
+	// unique index (1 / count of keys), as of the last statistics of that
+	// index. Read once for all the relations, on the first call.
+	if (! mRelationRowsRead)
+	{
+		mRelationRowsRead = true;
+		IBPP::Transaction tr = IBPP::TransactionFactory(this, IBPP::amRead,
+			IBPP::ilReadCommitted);
+		tr->Start();
+		IBPP::Statement st = IBPP::StatementFactory(this, tr,
+			"select RDB$RELATION_NAME, min(RDB$STATISTICS) from RDB$INDICES"
+			" where RDB$UNIQUE_FLAG = 1 and RDB$STATISTICS > 0"
+			" group by RDB$RELATION_NAME");
+		st->Execute();
+		while (st->Fetch())
+		{
+			std::string name;
+			double selectivity;
+			st->Get(1, name);
+			st->Get(2, selectivity);
+			name.erase(name.find_last_not_of(' ') + 1);
+			mRelationRows[name] = (int64_t)(1.0 / selectivity + 0.5);
+		}
+		st->Close();
+		tr->Commit();
+	}
+
+	std::map<std::string, int64_t>::const_iterator it = mRelationRows.find(relation);
+	return it == mRelationRows.end() ? -1 : it->second;
+}
+
+bool DatabaseImpl::Alive()
+{
+	// Cheapest check that the server still knows this attachment : a single
+	// round trip asking for a single item.
+	if (mHandle == 0) return false;
+
+	char items[] = {isc_info_attachment_id, isc_info_end};
+	IBS status;
+	RB result(32);
+
+	(*gds.Call()->m_database_info)(status.Self(), &mHandle, sizeof(items), items,
+		result.Size(), result.Self());
+	return status.Errors() ? false : true;
+}
+
+bool DatabaseImpl::Busy()
+{
+	// Still running a transaction or waiting for events
+	for (unsigned i = 0; i < mTransactions.size(); i++)
+		if (mTransactions[i]->Started()) return true;
+	return mEvents.empty() ? false : true;
+}
+
 void DatabaseImpl::AttachTransactionImpl(TransactionImpl* tr)
 {
 	if (tr == 0)
@@ -457,6 +668,73 @@ void DatabaseImpl::DetachEventsImpl(EventsImpl* ev)
 	mEvents.erase(std::find(mEvents.begin(), mEvents.end(), ev));
 }
 
+bool DatabaseImpl::CacheStatement(const std::string& sql, isc_stmt_handle handle,
+	IBPP::STT type, RowImpl* inRow, RowImpl* outRow)
+{
+	// On success, the cache owns the handle and the references to both rows
+	if (mCacheSize <= 0 || mHandle == 0) return false;
+
+	CachedStatement entry;
+	entry.handle = handle;
+	entry.type = type;
+	entry.inRow = inRow;
+	entry.outRow = outRow;
+	mCache.push_front(entry);
+	mCache.front().sql = mCacheIndex.insert(std::make_pair(sql, mCache.begin()));
+
+	while ((int)mCache.size() > mCacheSize) CacheEvict();
+	return true;
+}
+
+bool DatabaseImpl::UncacheStatement(const std::string& sql, isc_stmt_handle& handle,
+	IBPP::STT& type, RowImpl*& inRow, RowImpl*& outRow)
+{
+	// On success, the caller owns the handle and the references to both rows
+	if (mCacheSize <= 0) return false;
+
+	std::multimap<std::string, std::list<CachedStatement>::iterator>::iterator it =
+		mCacheIndex.find(sql);
+	if (it == mCacheIndex.end())
+	{
+		++mCacheMisses;
+		return false;
+	}
+
+	CachedStatement& entry = *it->second;
+	handle = entry.handle;
+	type = entry.type;
+	inRow = entry.inRow;
+	outRow = entry.outRow;
+	mCache.erase(it->second);
+	mCacheIndex.erase(it);
+	++mCacheHits;
+	return true;
+}
+
+void DatabaseImpl::CacheEvict()
+{
+	// Drops the least recently used statement. This is called from
+	// Statement::Close() and destructors, so server errors are ignored.
+	CachedStatement& entry = mCache.back();
+	if (entry.handle != 0)
+	{
+		IBS status;
+		(*gds.Call()->m_dsql_free_statement)(status.Self(), &entry.handle, DSQL_drop);
+	}
+	if (entry.inRow != 0) entry.inRow->Release();
+	if (entry.outRow != 0) entry.outRow->Release();
+	mCacheIndex.erase(entry.sql);
+	mCache.pop_back();
+	++mCacheEvictions;
+}
+
+void DatabaseImpl::ClearStatementCache()
+{
+	int evictions = mCacheEvictions;
+	while (! mCache.empty()) CacheEvict();
+	mCacheEvictions = evictions;	// Not evictions per se
+}
+
 DatabaseImpl::DatabaseImpl(const std::string& ServerName, const std::string& DatabaseName,
 						   const std::string& UserName, const std::string& UserPassword,
 						   const std::string& RoleName, const std::string& CharSet,
@@ -466,8 +744,12 @@ DatabaseImpl::DatabaseImpl(const std::string& ServerName, const std::string& Dat
 	mServerName(ServerName), mDatabaseName(DatabaseName),
 	mUserName(UserName), mUserPassword(UserPassword), mRoleName(RoleName),
 	mCharSet(CharSet), mCreateParams(CreateParams),
-	mDialect(3)
+	mDialect(3), mCacheSize(0), mCacheHits(0), mCacheMisses(0),
+	mCacheEvictions(0), mRelationRowsRead(false)
 {
+#ifdef _DEBUG
+	mThreadDepth = 0;
+#endif
 }
 
 DatabaseImpl::~DatabaseImpl()
@@ -476,6 +758,37 @@ DatabaseImpl::~DatabaseImpl()
 		catch(...) { }
 }
 
+//	(((((((( IBPP::DatabaseStats ))))))))
+
+IBPP::DatabaseStats IBPP::DatabaseStats::operator-(const IBPP::DatabaseStats& before) const
+{
+	IBPP::DatabaseStats delta(*this);
+	delta.fetches -= before.fetches;
+	delta.marks -= before.marks;
+	delta.reads -= before.reads;
+	delta.writes -= before.writes;
+
+	std::map<int, IBPP::RelationStats>::iterator it = delta.relations.begin();
+	while (it != delta.relations.end())
+	{
+		IBPP::RelationStats& r = it->second;
+		std::map<int, IBPP::RelationStats>::const_iterator b = before.relations.find(it->first);
+		if (b != before.relations.end())
+		{
+			r.inserts -= b->second.inserts;
+			r.updates -= b->second.updates;
+			r.deletes -= b->second.deletes;
+			r.readIdx -= b->second.readIdx;
+			r.readSeq -= b->second.readSeq;
+		}
+		if (r.inserts == 0 && r.updates == 0 && r.deletes == 0
+			&& r.readIdx == 0 && r.readSeq == 0)
+			delta.relations.erase(it++);
+		else ++it;
+	}
+	return delta;
+}
+
 //
 //	EOF
 //
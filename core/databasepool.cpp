@@ -0,0 +1,313 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, DatabasePool class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <utility>
+
+using namespace ibpp_internals;
+
+//	An attachment which stayed idle for more than that many seconds is checked
+//	to still be alive before being handed out again. Below that, the check
+//	would cost more than it saves.
+const int DatabasePoolImpl::PINGAFTER = 5;
+
+//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
+
+IBPP::Database DatabasePoolImpl::Acquire(int WaitMs)
+{
+	std::chrono::steady_clock::time_point deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(WaitMs);
+
+	std::unique_lock<std::mutex> guard(mLock);
+	for (;;)
+	{
+		// Most recently returned first, so that the others can age out
+		while (! mIdle.empty())
+		{
+			IdleDatabase idle = std::move(mIdle.back());
+			mIdle.pop_back();
+			DatabaseImpl* impl = dynamic_cast<DatabaseImpl*>(idle.db.intf());
+			if (std::chrono::steady_clock::now() - idle.since
+					< std::chrono::seconds(PINGAFTER))
+			{
+				mLent.push_back(impl);
+				return std::move(idle.db);
+			}
+
+			guard.unlock();
+			if (impl->Alive())
+			{
+				guard.lock();
+				mLent.push_back(impl);
+				return std::move(idle.db);
+			}
+			Discard(idle.db);
+			guard.lock();
+			--mOpen;
+		}
+
+		if (mOpen < mMaxSize)
+		{
+			// Counted right away, connected outside of the lock
+			++mOpen;
+			guard.unlock();
+			IBPP::Database db;
+			try { db = Open(); }
+			catch (...)
+			{
+				guard.lock();
+				--mOpen;
+				mReturned.notify_one();
+				throw;
+			}
+			guard.lock();
+			mLent.push_back(dynamic_cast<DatabaseImpl*>(db.intf()));
+			return db;
+		}
+
+		if (mReturned.wait_until(guard, deadline) == std::cv_status::timeout
+				&& mIdle.empty() && mOpen >= mMaxSize)
+			throw LogicExceptionImpl("DatabasePool::Acquire",
+				_("All %d attachments are in use."), mMaxSize);
+	}
+}
+
+void DatabasePoolImpl::Return(IBPP::Database& db)
+{
+	if (db.intf() == 0)
+		throw LogicExceptionImpl("DatabasePool::Return",
+			_("Can't return a null Database object."));
+
+	DatabaseImpl* impl = dynamic_cast<DatabaseImpl*>(db.intf());
+	{
+		// Only the attachments lent out by this pool, and only once
+		std::lock_guard<std::mutex> guard(mLock);
+		std::vector<DatabaseImpl*>::iterator lent =
+			std::find(mLent.begin(), mLent.end(), impl);
+		if (lent == mLent.end())
+			throw LogicExceptionImpl("DatabasePool::Return",
+				_("This Database was not acquired from this pool."));
+		mLent.erase(lent);
+	}
+	IBPP::Database returned = std::move(db);
+
+	if (! impl->Connected() || impl->Busy())
+	{
+		// Not worth keeping, which makes room for a fresh one
+		Discard(returned);
+		std::lock_guard<std::mutex> guard(mLock);
+		--mOpen;
+		mReturned.notify_one();
+		return;
+	}
+
+	std::vector<IBPP::Database> victims;
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		IdleDatabase idle;
+		idle.db = std::move(returned);
+		idle.since = std::chrono::steady_clock::now();
+		mIdle.push_back(std::move(idle));
+		Evict(victims);
+		mReturned.notify_one();
+	}
+	for (unsigned i = 0; i < victims.size(); i++)
+		Discard(victims[i]);
+}
+
+void DatabasePoolImpl::EvictIdle()
+{
+	std::vector<IBPP::Database> victims;
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		Evict(victims);
+	}
+	for (unsigned i = 0; i < victims.size(); i++)
+		Discard(victims[i]);
+}
+
+void DatabasePoolImpl::Sizes(int* Open, int* Idle)
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	if (Open != 0) *Open = mOpen;
+	if (Idle != 0) *Idle = (int)mIdle.size();
+}
+
+IBPP::IDatabasePool* DatabasePoolImpl::AddRef()
+{
+	ASSERTION(mRefCount >= 0);
+	++mRefCount;
+	return this;
+}
+
+void DatabasePoolImpl::Release()
+{
+	// Release cannot throw, except in DEBUG builds on assertion
+	ASSERTION(mRefCount >= 0);
+	try { if (--mRefCount <= 0) delete this; }
+		catch (...) { }
+}
+
+//	(((((((( OBJECT INTERNAL METHODS ))))))))
+
+IBPP::Database DatabasePoolImpl::Open()
+{
+	// Connects a new attachment, then prepares the warm statements on it.
+	// Closing them checks them into the statement cache of the attachment,
+	// where the first Prepare() of the same texts will find them.
+
+	DatabaseImpl* impl = new DatabaseImpl(mServerName, mDatabaseName,
+		mUserName, mUserPassword, mRoleName, mCharSet, "");
+	IBPP::Database db = impl;
+
+	if ((int)mWarmSql.size() > impl->StatementCacheSize())
+		impl->SetStatementCacheSize((int)mWarmSql.size());
+	impl->Connect();
+
+	if (! mWarmSql.empty())
+	{
+		TransactionImpl* trimpl = new TransactionImpl(impl, IBPP::amRead,
+			IBPP::ilReadCommitted);
+		IBPP::Transaction tr = trimpl;
+		tr->Start();
+		for (unsigned i = 0; i < mWarmSql.size(); i++)
+		{
+			IBPP::Statement st = new StatementImpl(impl, trimpl, "");
+			st->Prepare(mWarmSql[i]);
+			st->Close();
+		}
+		tr->Commit();
+	}
+
+	return db;
+}
+
+void DatabasePoolImpl::Evict(std::vector<IBPP::Database>& victims)
+{
+	// Called with mLock held. Takes out the attachments idle for too long,
+	// oldest first, down to MinSize. The caller disconnects them once the
+	// lock is released.
+
+	if (mIdleSeconds <= 0) return;
+
+	std::chrono::steady_clock::time_point limit =
+		std::chrono::steady_clock::now() - std::chrono::seconds(mIdleSeconds);
+	unsigned n = 0;
+	while (n < mIdle.size() && mOpen > mMinSize && mIdle[n].since < limit)
+	{
+		victims.push_back(std::move(mIdle[n].db));
+		--mOpen;
+		++n;
+	}
+	mIdle.erase(mIdle.begin(), mIdle.begin() + n);
+}
+
+void DatabasePoolImpl::Discard(IBPP::Database& db)
+{
+	try { if (db.intf() != 0 && db->Connected()) db->Disconnect(); }
+		catch (...) { }
+	db.clear();
+}
+
+DatabasePoolImpl::DatabasePoolImpl(const std::string& ServerName,
+	const std::string& DatabaseName, const std::string& UserName,
+	const std::string& UserPassword, const std::string& RoleName,
+	const std::string& CharSet, int MinSize, int MaxSize, int IdleSeconds,
+	const std::vector<std::string>& WarmSql)
+
+	: mRefCount(0), mServerName(ServerName), mDatabaseName(DatabaseName),
+	mUserName(UserName), mUserPassword(UserPassword), mRoleName(RoleName),
+	mCharSet(CharSet), mWarmSql(WarmSql), mMinSize(MinSize), mMaxSize(MaxSize),
+	mIdleSeconds(IdleSeconds), mOpen(0)
+{
+	if (MinSize < 0 || MaxSize < 1 || MinSize > MaxSize)
+		throw LogicExceptionImpl("DatabasePool", _("Invalid pool sizes, min %d, max %d."),
+			MinSize, MaxSize);
+
+	// The first attachments are opened in parallel : each one waits for the
+	// connection round trips and the preparation of the warm statements.
+	// Should any of them fail, the others are closed and its error rethrown.
+
+	std::vector<IBPP::Database> opened(MinSize);
+	std::vector<std::exception_ptr> errors(MinSize);
+	std::vector<std::thread> threads;
+	std::exception_ptr error;
+
+	try
+	{
+		for (int i = 0; i < MinSize; i++)
+			threads.push_back(std::thread([this, &opened, &errors, i]()
+				{
+					try { opened[i] = Open(); }
+					catch (...) { errors[i] = std::current_exception(); }
+				}));
+	}
+	catch (...) { error = std::current_exception(); }
+
+	for (unsigned i = 0; i < threads.size(); i++) threads[i].join();
+	for (int i = 0; i < MinSize && ! error; i++) error = errors[i];
+
+	if (error)
+	{
+		for (int i = 0; i < MinSize; i++) Discard(opened[i]);
+		std::rethrow_exception(error);
+	}
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	for (int i = 0; i < MinSize; i++)
+	{
+		IdleDatabase idle;
+		idle.db = std::move(opened[i]);
+		idle.since = now;
+		mIdle.push_back(std::move(idle));
+	}
+	mOpen = MinSize;
+}
+
+DatabasePoolImpl::~DatabasePoolImpl()
+{
+	for (unsigned i = 0; i < mIdle.size(); i++)
+		Discard(mIdle[i].db);
+}
+
+//
+//	EOF
+//
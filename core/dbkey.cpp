@@ -40,6 +40,7 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <utility>
 
 using namespace ibpp_internals;
 
@@ -115,6 +116,18 @@ IBPP::DBKey& IBPP::DBKey::operator=(const IBPP::DBKey& assigned)
 	return *this;
 }
 
+IBPP::DBKey::DBKey(DBKey&& moved) noexcept
+	: mDBKey(std::move(moved.mDBKey)), mString(std::move(moved.mString))
+{
+}
+
+IBPP::DBKey& IBPP::DBKey::operator=(IBPP::DBKey&& assigned)
+{
+	mDBKey.swap(assigned.mDBKey);
+	mString.swap(assigned.mString);
+	return *this;
+}
+
 //
 //	EOF
 //
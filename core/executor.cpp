@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, Executor class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+using namespace ibpp_internals;
+
+//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
+
+std::future<void> ExecutorImpl::Run(const std::function<void()>& work)
+{
+	if (! work)
+		throw LogicExceptionImpl("Executor::Run", _("No work given."));
+
+	return Submit<void>(work);
+}
+
+std::future<void> ExecutorImpl::ExecuteAsync(IBPP::Statement st, const std::string& sql)
+{
+	if (st.intf() == 0)
+		throw LogicExceptionImpl("Executor::ExecuteAsync",
+			_("Can't execute a null Statement object."));
+
+	return Submit<void>([st, sql]()
+		{
+			if (sql.empty()) st->Execute();
+			else st->Execute(sql);
+		});
+}
+
+std::future<IBPP::Row> ExecutorImpl::FetchAsync(IBPP::Statement st)
+{
+	if (st.intf() == 0)
+		throw LogicExceptionImpl("Executor::FetchAsync",
+			_("Can't fetch from a null Statement object."));
+
+	return Submit<IBPP::Row>([st]()
+		{
+			IBPP::Row row;
+			if (! st->Fetch(row)) row.clear();
+			return row;
+		});
+}
+
+std::future<void> ExecutorImpl::CommitAsync(IBPP::Transaction tr)
+{
+	if (tr.intf() == 0)
+		throw LogicExceptionImpl("Executor::CommitAsync",
+			_("Can't commit a null Transaction object."));
+
+	return Submit<void>([tr]() { tr->Commit(); });
+}
+
+void ExecutorImpl::SetNotify(const std::function<void()>& notify)
+{
+	std::lock_guard<std::mutex> guard(mLock);
+	mNotify = notify;
+}
+
+IBPP::Database ExecutorImpl::DatabasePtr() const
+{
+	return mDatabase;
+}
+
+IBPP::IExecutor* ExecutorImpl::AddRef()
+{
+	ASSERTION(mRefCount >= 0);
+	++mRefCount;
+	return this;
+}
+
+void ExecutorImpl::Release()
+{
+	// Release cannot throw, except in DEBUG builds on assertion
+	ASSERTION(mRefCount >= 0);
+	try
+	{
+		if (--mRefCount <= 0)
+		{
+			if (std::this_thread::get_id() != mThread.get_id()) delete this;
+			else
+			{
+				// The last reference went away in some work (a coroutine
+				// resumed by Await() for instance) : the thread can't join
+				// itself, it deletes the executor once its queue is done.
+				std::lock_guard<std::mutex> guard(mLock);
+				mStopping = true;
+				mOrphaned = true;
+				mThread.detach();
+			}
+		}
+	}
+		catch (...) { }
+}
+
+//	(((((((( OBJECT INTERNAL METHODS ))))))))
+
+void ExecutorImpl::Post(const std::function<void()>& work)
+{
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		if (mStopping)
+			throw LogicExceptionImpl("Executor", _("The executor is stopping."));
+		mQueue.push_back(work);
+	}
+	mWake.notify_one();
+}
+
+void ExecutorImpl::Loop()
+{
+	for (;;)
+	{
+		std::function<void()> work;
+		std::function<void()> notify;
+		bool orphaned = false;
+		{
+			std::unique_lock<std::mutex> guard(mLock);
+			while (mQueue.empty() && ! mStopping) mWake.wait(guard);
+			if (mQueue.empty()) orphaned = mOrphaned;	// Stopping, all work done
+			else
+			{
+				work = std::move(mQueue.front());
+				mQueue.pop_front();
+				notify = mNotify;
+			}
+		}
+		if (! work)
+		{
+			if (orphaned) delete this;	// Nobody else will, see Release()
+			return;
+		}
+
+		// The packaged tasks keep their exceptions for the futures. The
+		// objects captured by the work are released before notifying.
+		try { work(); }
+			catch (...) { }
+		work = nullptr;
+
+		if (notify)
+		{
+			try { notify(); }
+				catch (...) { }
+		}
+	}
+}
+
+ExecutorImpl::ExecutorImpl(DatabaseImpl* database)
+	: mRefCount(0), mDatabase(database), mStopping(false), mOrphaned(false)
+{
+	if (database == 0)
+		throw LogicExceptionImpl("Executor", _("Can't work on a null Database object."));
+
+	mThread = std::thread(&ExecutorImpl::Loop, this);
+}
+
+ExecutorImpl::~ExecutorImpl()
+{
+	// Lets the pending work complete, then stops the thread
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		mStopping = true;
+	}
+	mWake.notify_one();
+	try { if (mThread.joinable()) mThread.join(); }
+		catch (...) { }
+}
+
+//
+//	EOF
+//
@@ -42,6 +42,26 @@
 //
 //	Select the platform:	IBPP_WINDOWS | IBPP_LINUX | IBPP_DARWIN
 //
+//	IBPP requires a C++11 compiler.
+//
+//	THREADING
+//	The library initialization (loading of the client library) is done once,
+//	whichever thread gets there first. Smart pointers (Database, Row, ...) may
+//	be copied and released from any thread : the reference counts are atomic.
+//	Beyond that, each object is used by one thread at a time :
+//	- A Database and everything attached to it (Transaction, Statement, Blob,
+//	  Array, Events) belong together. Use them from one thread at a time, or
+//	  use one attachment per thread.
+//	- A Row obtained from Statement::Fetch(Row&), and the Date, Time, Timestamp,
+//	  DBKey values read from it, may be handed to another thread which then
+//	  owns it. Reading its values needs no lock, nor does releasing it while
+//	  the statement keeps fetching. Get/Set of a Blob or Array through a row
+//	  use the row's attachment and are subject to the rule above.
+//	- The same Row must not be read by one thread while another modifies it.
+//	Debug builds (_DEBUG) throw a LogicException when a second thread calls
+//	a Database, or a Transaction, Statement, Blob or Array of it, while
+//	another thread is inside a call which reaches the server.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef __IBPP_H__
@@ -88,9 +108,25 @@
 #endif
 
 #include <exception>
+#include <functional>
+#include <future>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
+#if defined(__cpp_impl_coroutine)		// C++20 compilers
+#include <coroutine>
+#if defined(__cpp_lib_coroutine)
+#define IBPP_COROUTINES
+#endif
+#endif
+
+namespace ibpp_internals
+{
+	class StatementImpl;	// Fills the IBPP::ColumnBatch
+}
+
 namespace IBPP
 {
 	//	Typically you use this constant in a call IBPP::CheckVersion as in:
@@ -154,6 +190,34 @@ namespace IBPP
 	// TransactionFactory Flags
 	enum TFF {tfIgnoreLimbo = 0x1, tfAutoCommit = 0x2, tfNoAutoUndo = 0x4};
 
+	//	Statement::Prefetch Policies, when the ring of rows is full
+	enum PFP {pfWait, pfGrow};
+
+	//	ParallelScan Orders
+	enum PSO {psUnordered, psByKey};
+
+	//	Plan Node Types
+	enum PNT {pnPlan, pnJoin, pnSort, pnMerge, pnHash,
+		pnNatural, pnIndex, pnOrder};
+
+	//	Plan Alert Kinds
+	enum PAK {paNaturalScan, paPlanChanged};
+
+	//	Traced Operations, one per call of the client library
+	enum TOP {toCreateDatabase, toAttachDatabase, toDetachDatabase,
+		toDropDatabase, toDatabaseInfo, toStartTransaction, toCommit,
+		toCommitRetaining, toRollback, toRollbackRetaining, toExecuteImmediate,
+		toAllocateStatement, toPrepare, toDescribe, toDescribeBind, toExecute,
+		toExecute2, toFetch, toFreeStatement, toSetCursorName, toStatementInfo,
+		toOpenBlob, toCreateBlob, toGetSegment, toPutSegment, toCloseBlob,
+		toCancelBlob, toBlobInfo, toArrayLookupBounds, toArrayGetSlice,
+		toArrayPutSlice, toQueEvents, toCancelEvents, toServiceAttach,
+		toServiceDetach, toServiceStart, toServiceQuery};
+
+	//	ColumnBatch Column Types
+	enum BCT {bcInt16, bcInt32, bcInt64, bcFloat, bcDouble,
+		bcDate, bcTime, bcTimestamp, bcString};
+
 	/* IBPP never return any error codes. It throws exceptions.
 	 * On database engine reported errors, an IBPP::SQLException is thrown.
 	 * In all other cases, IBPP throws IBPP::LogicException.
@@ -361,7 +425,9 @@ namespace IBPP
 		const char* AsString() const;
 
 		DBKey& operator=(const DBKey&);	// Assignment operator
+		DBKey& operator=(DBKey&&);		// Move assignment operator
 		DBKey(const DBKey&);			// Copy Constructor
+		DBKey(DBKey&&) noexcept;		// Move Constructor
 		DBKey() { }
 		~DBKey() { }
 	};
@@ -381,15 +447,284 @@ namespace IBPP
 
 	private:
 		void copyfrom(const User& r);
+		void movefrom(User& r);
 
 	public:
 		void clear();
 		User& operator=(const User& r)	{ copyfrom(r); return *this; }
+		User& operator=(User&& r)		{ movefrom(r); return *this; }
 		User(const User& r)				{ copyfrom(r); }
+		User(User&& r)					{ movefrom(r); }
 		User() : userid(0), groupid(0)	{ }
 		~User() { };
 	};
 
+	/* Class ColumnBatch receives the rows read by IStatement::FetchBatch(),
+	 * stored column by column instead of row by row. Each column holds its
+	 * values in one contiguous array of a native type, along with a bitmap
+	 * of the NULL indicators, so that a whole batch can be handed over to
+	 * vectorized code. Columns are numbered from 1 (as everywhere in IBPP),
+	 * rows of the batch from 0. The native type of a column is:
+	 *	bcInt16, bcInt32, bcInt64 : int16_t, int32_t, int64_t (for NUMERIC and
+	 *		DECIMAL columns, the unscaled integer; divide by 10^Scale())
+	 *	bcFloat, bcDouble : float, double
+	 *	bcDate, bcTime : int32_t, as IBPP::Date::GetDate() and Time::GetTime()
+	 *	bcTimestamp : pairs of int32_t, the date then the time, as above
+	 *	bcString : the characters of all the rows, back to back. The string
+	 *		of row r goes from Offsets()[r] up to Offsets()[r+1] (CHAR columns
+	 *		keep their trailing blanks).
+	 * NULL values have a zero value, or an empty string. FetchBatch() returns
+	 * the count of rows read, which is zero once the result set is exhausted.
+	 * Blob and array columns are not supported, use Fetch() for those. */
+
+	class ColumnBatch
+	{
+	private:
+		friend class ibpp_internals::StatementImpl;
+
+		struct Column
+		{
+			BCT type;
+			int scale;
+			std::vector<char> values;		// Fixed size values, or characters
+			std::vector<int32_t> offsets;	// Offsets in values (bcString)
+			std::vector<unsigned char> nulls;	// Bit set when NULL
+		};
+
+		std::vector<Column> mColumns;
+		int mRows;
+
+	public:
+		int Rows() const	{ return mRows; }
+		int Columns() const	{ return (int)mColumns.size(); }
+		BCT Type(int col) const;
+		int Scale(int col) const;
+		bool IsNull(int col, int row) const;
+		const unsigned char* Nulls(int col) const;
+		const void* Values(int col) const;
+		const int32_t* Offsets(int col) const;
+		std::string String(int col, int row) const;
+		void Clear();
+		void Swap(ColumnBatch& other)
+			{ mColumns.swap(other.mColumns); std::swap(mRows, other.mRows); }
+
+		ColumnBatch() : mRows(0) { }
+		~ColumnBatch() { }
+	};
+
+	/* Class BatchError describes a row of parameters which failed in
+	 * IStatement::ExecuteBatch() : its number in the batch (from 0) and the
+	 * error, as an SQLException would have reported it. */
+
+	class BatchError
+	{
+	public:
+		int row;
+		int sqlcode;
+		int enginecode;
+		std::string message;
+
+		BatchError() : row(0), sqlcode(0), enginecode(0) { }
+	};
+
+	/* Class Status is returned by the Try...() methods (IStatement::TryExecute()
+	 * and TryFetch(), ITransaction::TryCommit() and TryCommitRetain()) instead
+	 * of throwing an SQLException, for the failures which are expected under
+	 * contention : lock conflicts, unique violations... Ok() tells whether the
+	 * call succeeded, else SqlCode() and EngineCode() are those the exception
+	 * would have reported, and Message() formats its text on first use only
+	 * (the strings of the error are copied by the Status).
+	 * The misuses (LogicException) are still thrown. */
+
+	class Status
+	{
+	private:
+		long mVector[20];			// Status vector of the failed call, its
+		std::string mStrings;		// strings kept here (offsets in mVector)
+		const char* mContext;		// Method which failed
+		mutable std::string mMessage;
+
+		void Vector(long*) const;	// The status vector, as the calls left it
+
+	public:
+		bool Ok() const { return mVector[1] == 0; }
+		int SqlCode() const;
+		int EngineCode() const { return (int)mVector[1]; }
+		const char* Context() const { return mContext; }
+		const char* Message() const;
+
+		Status();
+		Status(const long* vector, const char* context);	// Of a failed call
+	};
+
+	/* Class RetryPolicy tells IBPP::Retry() how many times to run the work,
+	 * how long to pause between the runs and for how long to keep trying. */
+
+	class RetryPolicy
+	{
+	public:
+		int maxAttempts;		// Runs of the work, 1 for no retry
+		int firstDelayMs;		// Pause before the first retry, doubled then
+		int maxDelayMs;			// Longest pause
+		int deadlineMs;			// No retry after this time, 0 for no limit
+		double jitter;			// Part of each pause taken off at random
+
+		RetryPolicy() : maxAttempts(5), firstDelayMs(10), maxDelayMs(1000),
+			deadlineMs(10000), jitter(0.5) { }
+	};
+
+	/* Class RelationStats holds the record level counters of one relation
+	 * (table) in a DatabaseStats, those which isql shows with SET STATS. */
+
+	class RelationStats
+	{
+	public:
+		std::string name;
+		int64_t inserts;
+		int64_t updates;
+		int64_t deletes;
+		int64_t readIdx;		// Records read through an index
+		int64_t readSeq;		// Records read by a natural scan
+
+		RelationStats() : inserts(0), updates(0), deletes(0), readIdx(0),
+			readSeq(0) { }
+	};
+
+	/* Class DatabaseStats is a snapshot of the counters of an attachment,
+	 * taken in one isc_database_info() call by IDatabase::Statistics(). The
+	 * relations are keyed by their id, their names being read when a new id
+	 * shows up, before the counters are taken again : the reads of that query
+	 * don't end up in the next difference. Subtracting an earlier snapshot
+	 * gives the work done in between : the counters are differences (only the
+	 * relations which changed are kept), the page and buffer figures those of
+	 * the later. */
+
+	class DatabaseStats
+	{
+	public:
+		int64_t fetches;		// Pages read from the cache
+		int64_t marks;			// Pages written to the cache
+		int64_t reads;			// Pages read from the disk
+		int64_t writes;			// Pages written to the disk
+		int pageSize;
+		int pages;				// Allocated pages
+		int buffers;			// Pages of the cache
+		int64_t currentMemory;	// Bytes used by the server
+		int64_t maxMemory;
+		std::map<int, RelationStats> relations;
+
+		DatabaseStats operator-(const DatabaseStats& before) const;
+
+		DatabaseStats() : fetches(0), marks(0), reads(0), writes(0), pageSize(0),
+			pages(0), buffers(0), currentMemory(0), maxMemory(0) { }
+	};
+
+	/* Class PerfStats mirrors the PERF block of Firebird (perf.h), which isql
+	 * shows with SET STATS. A snapshot holds the page counters and the memory
+	 * of the attachments, the time and the CPU time used by this process so
+	 * far. Subtracting an earlier snapshot gives the cost of the work done in
+	 * between, deltaMemory then being the change of the current memory. See
+	 * IStatement::SetPerfStats() and ITransaction::SetPerfStats(). */
+
+	class PerfStats
+	{
+	public:
+		int64_t fetches;
+		int64_t marks;
+		int64_t reads;
+		int64_t writes;
+		int64_t currentMemory;
+		int64_t maxMemory;
+		int64_t deltaMemory;
+		int buffers;
+		int pageSize;
+		double elapsedMs;
+		double cpuMs;			// User and system time of this process
+
+		PerfStats operator-(const PerfStats& before) const;
+
+		PerfStats() : fetches(0), marks(0), reads(0), writes(0), currentMemory(0),
+			maxMemory(0), deltaMemory(0), buffers(0), pageSize(0), elapsedMs(0),
+			cpuMs(0) { }
+	};
+
+	/* Class PlanNode is one node of an execution plan, as ParsePlan() and
+	 * IStatement::Plan(std::vector<PlanNode>&) read it from the text of the
+	 * server. Each PLAN of the text (one per query and sub-query) gives a
+	 * pnPlan node, whose children are its streams : a single one, or those of
+	 * the implicit join of 'PLAN (A NATURAL, B NATURAL)'. The pnJoin, pnSort,
+	 * pnMerge and pnHash nodes have children too. The leaves are the
+	 * relations : read in storage order (pnNatural), through the indexes
+	 * listed (pnIndex), or walking the order index (pnOrder, maybe with
+	 * indexes too). The relation is its name or alias in the plan, prefixed
+	 * with the view for the relations of a view ("V T"). */
+
+	class PlanNode
+	{
+	public:
+		PNT type;
+		std::string relation;
+		std::string order;
+		std::vector<std::string> indexes;
+		std::vector<PlanNode> children;
+
+		PlanNode() : type(pnPlan) { }
+	};
+
+	/* Class PlanAlert is what a PlanPolicy reports : a natural scan of a
+	 * relation believed larger than the policy allows (its estimated rows),
+	 * or a plan other than the one of the baseline (previous). */
+
+	class PlanAlert
+	{
+	public:
+		PAK kind;
+		std::string sql;
+		std::string fingerprint;	// See QueryFingerprint()
+		std::string plan;
+		std::string previous;		// paPlanChanged
+		std::string relation;		// paNaturalScan
+		int64_t rows;				// paNaturalScan
+
+		PlanAlert() : kind(paNaturalScan), rows(0) { }
+	};
+
+	/* Class PlanPolicy is what SetPlanPolicy() applies to the Prepare() of
+	 * each new SQL fingerprint of the process. The rows of a relation are
+	 * estimated from the selectivity of its unique indexes, as of their last
+	 * statistics : naturalRows flags the natural scans of the relations
+	 * known to be larger (-1 for none, 0 for all of them). The baseline holds
+	 * the plans expected by fingerprint, as PlanCapture() gave them during
+	 * an earlier run, a different plan being flagged. */
+
+	class PlanPolicy
+	{
+	public:
+		int64_t naturalRows;
+		std::map<std::string, std::string> baseline;
+		std::function<void(const PlanAlert&)> alert;
+
+		PlanPolicy() : naturalRows(-1) { }
+	};
+
+	/* Class ColumnHandle is a column of a row or a result set, looked up by
+	 * name once (IRow::Column(), IStatement::Column()) and then passed
+	 * wherever a column number is expected, to avoid the name lookup of
+	 * each Get(const std::string&, ...) inside fetch loops. */
+
+	class ColumnHandle
+	{
+	private:
+		int mNum;
+
+	public:
+		bool IsValid() const	{ return mNum > 0; }
+		operator int() const	{ return mNum; }
+
+		explicit ColumnHandle(int num) : mNum(num) { }
+		ColumnHandle() : mNum(0) { }
+	};
+
 	//	Interface Wrapper
 	template <class T>
 	class Ptr
@@ -427,8 +762,21 @@ namespace IBPP
 			mObject = tmp; return *this;
 		}
 
+		Ptr& operator=(Ptr&& r)
+		{
+			// Takes over the reference of r, no AddRef/Release pair
+			if (&r != this)
+			{
+				T* tmp = r.mObject; r.mObject = 0;
+				if (mObject != 0) mObject->Release();
+				mObject = tmp;
+			}
+			return *this;
+		}
+
 		Ptr(T* p) : mObject(p == 0 ? 0 : p->AddRef()) { }
 		Ptr(const Ptr& r) : mObject(r.intf() == 0 ? 0 : r->AddRef()) {  }
+		Ptr(Ptr&& r) noexcept : mObject(r.mObject) { r.mObject = 0; }
 
 		Ptr() : mObject(0) { }
 		~Ptr() { clear(); }
@@ -454,6 +802,10 @@ namespace IBPP
 	class IStatement;		typedef Ptr<IStatement> Statement;
 	class IEvents;			typedef Ptr<IEvents> Events;
 	class IRow;				typedef Ptr<IRow> Row;
+	class IDatabasePool;	typedef Ptr<IDatabasePool> DatabasePool;
+	class IExecutor;		typedef Ptr<IExecutor> Executor;
+	class IParallelScan;	typedef Ptr<IParallelScan> ParallelScan;
+	class IBulkLoader;	typedef Ptr<IBulkLoader> BulkLoader;
 
 	/* IBlob is the interface to the blob capabilities of IBPP. Blob is the
 	 * object class you actually use in your programming. In Firebird, at the
@@ -557,7 +909,11 @@ namespace IBPP
 
 	/*	IDatabase is the interface to the database connections in IBPP. Database
 	 * is the object class you actually use in your programming. With a Database
-	 * object, you can create/drop/connect databases. */
+	 * object, you can create/drop/connect databases. A Database can also keep a
+	 * cache of prepared statements (see SetStatementCacheSize(), off by
+	 * default) : a Statement that is closed or prepared again leaves its
+	 * prepared statement there, and a later Prepare() of the very same SQL text
+	 * on that Database takes it back without any round trip to the server. */
 
 	class EventInterface;	// Cross-reference between EventInterface and IDatabase
 	
@@ -579,9 +935,14 @@ namespace IBPP
 			int* Reads, int* Writes) = 0;
 		virtual void Counts(int* Insert, int* Update, int* Delete, 
 			int* ReadIdx, int* ReadSeq) = 0;
+		virtual void Statistics(DatabaseStats&) = 0;
 		virtual void Users(std::vector<std::string>& users) = 0;
 		virtual int Dialect() = 0;
 
+		virtual void SetStatementCacheSize(int size) = 0;
+		virtual void StatementCacheStatistics(int* Hits, int* Misses,
+			int* Evictions) = 0;
+
 		virtual void Create(int dialect) = 0;
 		virtual void Connect() = 0;
 		virtual bool Connected() = 0;
@@ -601,13 +962,21 @@ namespace IBPP
 	 * allowing for distributed transactions spanning multiple databases,
 	 * possibly located on different servers. IBPP is one among the few
 	 * programming interfaces to Firebird that allows you to support distributed
-	 * transactions. */
+	 * transactions. With lrWait, a LockTimeout (in seconds, Firebird 2.0 and
+	 * later) makes the waits for a lock held by another transaction fail
+	 * after that time, instead of lasting until that transaction ends.
+	 * TryCommit() and TryCommitRetain() return a failure of the server as a
+	 * Status instead of throwing it (see Status).
+	 * With SetPerfStats(true), each commit is measured as with isql's SET
+	 * STATS, over all the attached databases, and PerfStatistics() tells the
+	 * cost of the last one (see PerfStats). */
 
 	class ITransaction
 	{
 	public:
 	    virtual void AttachDatabase(Database db, TAM am = amWrite,
-			TIL il = ilConcurrency, TLR lr = lrWait, TFF flags = TFF(0)) = 0;
+			TIL il = ilConcurrency, TLR lr = lrWait, TFF flags = TFF(0),
+				int LockTimeout = 0) = 0;
 	    virtual void DetachDatabase(Database db) = 0;
 	 	virtual void AddReservation(Database db,
 	 			const std::string& table, TTR tr) = 0;
@@ -618,6 +987,10 @@ namespace IBPP
 	    virtual void Rollback() = 0;
 	    virtual void CommitRetain() = 0;
 		virtual void RollbackRetain() = 0;
+		virtual Status TryCommit() = 0;
+		virtual Status TryCommitRetain() = 0;
+		virtual void SetPerfStats(bool on) = 0;
+		virtual void PerfStatistics(PerfStats&) = 0;
 
 		virtual ITransaction* AddRef() = 0;
 		virtual void Release() = 0;
@@ -682,6 +1055,7 @@ namespace IBPP
 		virtual bool Get(const std::string&, Array&) = 0;
 
 		virtual int ColumnNum(const std::string&) = 0;
+		virtual ColumnHandle Column(const std::string&) = 0;
 		virtual const char* ColumnName(int) = 0;
 		virtual const char* ColumnAlias(int) = 0;
 		virtual const char* ColumnTable(int) = 0;
@@ -709,7 +1083,41 @@ namespace IBPP
 	 * Statement object is the work horse of IBPP. All your data manipulation
 	 * statements will be done through it. It is also used to access the result
 	 * set of a query (when the statement is such), one row at a time and in
-	 * strict forward direction. */
+	 * strict forward direction. A query known to return at most one row can
+	 * use ExecuteSingleton() instead of Execute() and Fetch() : the row comes
+	 * back with the execution, no cursor is opened, and the return value tells
+	 * whether a row was found. Many rows of parameters can be queued by
+	 * AddBatch() (which takes the values currently Set()) and then sent by
+	 * ExecuteBatch(), chunk rows at a time. On Firebird 2.0 and later, each
+	 * chunk runs as a single EXECUTE BLOCK statement, undone as a whole when
+	 * one of its rows fails : its halves are then run again, down to the
+	 * failing rows, so that the others are still applied by blocks.
+	 * ExecuteBatch() returns the count of affected rows of each parameters
+	 * row (-1 when it failed) and a BatchError for each failed row. A
+	 * prepared Statement can be moved to another Transaction of the same
+	 * Database with AttachTransaction(), without being prepared again.
+	 * TryExecute() and TryFetch() are Execute() and Fetch() of a prepared
+	 * statement, returning a failure of the server as a Status instead of
+	 * throwing it (see Status).
+	 * Prefetch(), called after Execute(), starts a thread which keeps fetching
+	 * the result set into a ring of RingSize rows, while Fetch() and
+	 * Fetch(Row&) take the rows from the ring. When the ring is full, that
+	 * thread waits for the consumer (pfWait) or keeps fetching and lets the
+	 * ring grow (pfGrow), up to 65536 rows (or RingSize if larger) after
+	 * which it waits too. Anything the thread fails on is thrown by the
+	 * Fetch() which reaches that point, or returned by TryFetch() when the
+	 * server failed the fetch. PrefetchStatistics() tells how many
+	 * rows were prefetched, how many times Fetch() had to wait for a row
+	 * (Stalls) and how many times the thread waited for room (Waits).
+	 * Prefetching stops at the end of the result set or with the cursor
+	 * (Close(), Execute()...). Meanwhile, using other objects of the same
+	 * Database, including the blobs and arrays of the rows, relies on a
+	 * thread-safe client library (Firebird 2.5 and later). FetchBatch()
+	 * can't be used while prefetching.
+	 * SetPerfStats(true) turns on the measures of isql's SET STATS : from
+	 * the start of each Execute() to the end of its result set (or the close
+	 * of its cursor), PerfStatistics() then telling the cost of the last one
+	 * (see PerfStats). It costs two isc_database_info() calls per execution. */
 
 	class IStatement
 	{
@@ -717,11 +1125,24 @@ namespace IBPP
 		virtual void Prepare(const std::string&) = 0;
 		virtual void Execute() = 0;
 		virtual void Execute(const std::string&) = 0;
+		virtual bool ExecuteSingleton() = 0;
+		virtual bool ExecuteSingleton(const std::string&) = 0;
 		virtual void ExecuteImmediate(const std::string&) = 0;
 		virtual void CursorExecute(const std::string& cursor) = 0;
 		virtual void CursorExecute(const std::string& cursor, const std::string&) = 0;
 		virtual bool Fetch() = 0;
 		virtual bool Fetch(Row&) = 0;
+		virtual Status TryExecute() = 0;
+		virtual Status TryFetch(bool& fetched) = 0;
+		virtual int FetchBatch(ColumnBatch&, int rows) = 0;
+		virtual void Prefetch(int RingSize = 64, PFP policy = pfWait) = 0;
+		virtual void PrefetchStatistics(int* Rows, int* Stalls, int* Waits) = 0;
+		virtual void SetPerfStats(bool on) = 0;
+		virtual void PerfStatistics(PerfStats&) = 0;
+		virtual void AddBatch() = 0;
+		virtual void ClearBatch() = 0;
+		virtual void ExecuteBatch(std::vector<int>& affected,
+			std::vector<BatchError>& errors, int chunk = 0) = 0;
 		virtual int AffectedRows() = 0;
 		virtual void Close() = 0;
 		virtual std::string& Sql() = 0;
@@ -777,6 +1198,7 @@ namespace IBPP
 		virtual bool Get(const std::string&, Array& value) = 0;
 
 		virtual int ColumnNum(const std::string&) = 0;
+		virtual ColumnHandle Column(const std::string&) = 0;
 		virtual const char* ColumnName(int) = 0;
 		virtual const char* ColumnAlias(int) = 0;
 		virtual const char* ColumnTable(int) = 0;
@@ -793,7 +1215,9 @@ namespace IBPP
 		virtual int Parameters() = 0;
 
 		virtual void Plan(std::string&) = 0;
+		virtual void Plan(std::vector<PlanNode>&) = 0;
 
+		virtual void AttachTransaction(Transaction) = 0;
 		virtual	Database DatabasePtr() const = 0;
 		virtual Transaction TransactionPtr() const = 0;
 
@@ -836,6 +1260,277 @@ namespace IBPP
 	    virtual ~IEvents() { };
 	};
 	
+	/* IDatabasePool keeps connected Database objects to one database, ready
+	 * to be lent to the threads or requests of an application. MinSize of them
+	 * are connected when the pool is created, in parallel. Acquire() hands out
+	 * an idle one (checked to be still alive if it stayed idle for a few
+	 * seconds) or connects a new one, up to MaxSize. Beyond that, it waits up
+	 * to WaitMs milliseconds for one to be returned, then throws.
+	 * Return() takes it back and clears your Database : drop its transactions,
+	 * statements, blobs... first. Returning a Database which this pool did not
+	 * hand out, or returning it twice, throws a LogicException. One that is
+	 * still running a transaction, waiting for events or no longer connected
+	 * is disconnected instead of being kept. Idle attachments beyond MinSize
+	 * are disconnected after IdleSeconds (0 keeps them), checked on Return()
+	 * and EvictIdle().
+	 * Each new attachment prepares the WarmSql texts once and keeps them in
+	 * its statement cache (see IDatabase::SetStatementCacheSize), so that the
+	 * first Prepare() of those texts on it costs no round trip. */
+
+	class IDatabasePool
+	{
+	public:
+		virtual Database Acquire(int WaitMs = 0) = 0;
+		virtual void Return(Database&) = 0;
+		virtual void EvictIdle() = 0;
+		virtual void Sizes(int* Open, int* Idle) = 0;
+
+		virtual IDatabasePool* AddRef() = 0;
+		virtual void Release() = 0;
+
+		virtual ~IDatabasePool() { };
+	};
+
+	/* IExecutor runs the work of one attachment on a thread of its own, so
+	 * that the calling thread never blocks on the server. Work is run in the
+	 * order it was submitted and each call returns a std::future of its
+	 * result, which also carries the exceptions. FetchAsync() returns the
+	 * fetched Row, or a null Row past the last one. Run() accepts any work
+	 * on the attachment's objects.
+	 * While work is pending, the objects of the attachment (Database,
+	 * Transaction, Statement...) belong to the executor thread : do not use
+	 * them from other threads, nor release the executor from its own work.
+	 * SetNotify() installs a function called on the executor thread after
+	 * each completed piece of work. It should be short : writing to an eventfd
+	 * or a pipe wakes an epoll/select loop, which then collects the futures
+	 * that are ready. Releasing the executor waits for the pending work. */
+
+	class IExecutor
+	{
+	public:
+		virtual std::future<void> Run(const std::function<void()>& work) = 0;
+		virtual std::future<void> ExecuteAsync(Statement, const std::string& sql = "") = 0;
+		virtual std::future<Row> FetchAsync(Statement) = 0;
+		virtual std::future<void> CommitAsync(Transaction) = 0;
+		virtual void SetNotify(const std::function<void()>& notify) = 0;
+		virtual Database DatabasePtr() const = 0;
+
+		virtual IExecutor* AddRef() = 0;
+		virtual void Release() = 0;
+
+		virtual ~IExecutor() { };
+	};
+
+	/* IParallelScan reads a SELECT by Parts ranges of an integer key, each
+	 * range through its own attachment (same parameters as the Database given
+	 * to the factory), its own read-only concurrency transaction and its own
+	 * thread. Each range runs
+	 *		select * from (<sql>) where <key> between ? and ?
+	 * (a derived table, Firebird 2.0 and later) : key is a column of the
+	 * result, which should be indexed. The key goes from the low to the high
+	 * given to SetRange(), else from the min to the max of the key, queried
+	 * first through the Database given to the factory, then connected.
+	 * The threads start with the first Fetch() or FetchBatch(), which then
+	 * return the rows as they come (psUnordered) or ordered by the key
+	 * (psByKey : each range is sorted, and the ranges are read in turn).
+	 * A scan is read either by Fetch() or by FetchBatch(), whose batches all
+	 * have the size asked by its first call. The attachments are closed at
+	 * the end of the scan, on an error or by Close().
+	 * key is one column name, quoted before going into the SQL text (a
+	 * LogicException otherwise). Each range reads its own snapshot of the
+	 * database. The rows are not attached to any Database : reading their
+	 * Blob and Array columns throws a LogicException. */
+
+	class IParallelScan
+	{
+	public:
+		virtual void SetRange(int64_t low, int64_t high) = 0;
+		virtual bool Fetch(Row&) = 0;
+		virtual int FetchBatch(ColumnBatch&, int rows) = 0;
+		virtual void Close() = 0;
+
+		virtual IParallelScan* AddRef() = 0;
+		virtual void Release() = 0;
+
+		virtual ~IParallelScan() { };
+	};
+
+	/* Class BulkLoaderStats is what IBulkLoader::Statistics() reports. The
+	 * rows are counted once committed (loaded) or given up (failed). The
+	 * latency of a row goes from its Add() to its commit. */
+
+	class BulkLoaderStats
+	{
+	public:
+		int64_t added;			// Rows given to Add()
+		int64_t loaded;			// Rows inserted and committed
+		int64_t failed;			// Rows in error, see IBulkLoader::Errors()
+		int64_t retried;		// Rows run again after a lock conflict
+		int64_t commits;
+		double seconds;			// Since the loader was created
+		double rowsPerSecond;	// Loaded rows
+		double avgBatchMs;		// Time of one ExecuteBatch()
+		double maxBatchMs;
+		double avgLatencyMs;
+		double maxLatencyMs;
+
+		BulkLoaderStats() : added(0), loaded(0), failed(0), retried(0),
+			commits(0), seconds(0), rowsPerSecond(0), avgBatchMs(0),
+			maxBatchMs(0), avgLatencyMs(0), maxLatencyMs(0) { }
+	};
+
+	/* IBulkLoader runs an INSERT (or any statement taking parameters) for
+	 * many rows, through Parts attachments (same parameters as the Database
+	 * given to the factory), each with its own thread, its own read-committed
+	 * no-wait transaction and its own prepared statement, which runs the rows
+	 * by batches (see IStatement::ExecuteBatch()). Each attachment commits
+	 * once it has CommitRows rows pending, or when the first of them is
+	 * CommitMs old, and starts its transaction again.
+	 * NewRow() returns a Row of the parameters : Set() them all, then Add()
+	 * it, from any thread. Add() queues a copy (the Row may be set again right
+	 * away) for the attachment with the shortest queue, and blocks while the
+	 * queued rows take more than MemoryBudget bytes. The rows which hit a lock
+	 * conflict are run again after a pause of 10 ms, doubled up to 1 s on each
+	 * try, less up to half at random. The rows inserted before are committed
+	 * first, so that no locks are held during the pause. Those still failing,
+	 * and the rows in error, are counted as failed and reported by Errors()
+	 * (the first thousand), numbered in the order of Add() from 0.
+	 * Flush() returns once all the rows added are committed. Close() flushes,
+	 * then closes the attachments. When an attachment fails, its queued rows
+	 * are lost and Add(), Flush() and Close() throw its error.
+	 * The order of the rows is not kept across attachments. Blob and Array
+	 * parameters can't be set. */
+
+	class IBulkLoader
+	{
+	public:
+		virtual Row NewRow() = 0;
+		virtual void Add(const Row&) = 0;
+		virtual void Flush() = 0;
+		virtual void Close() = 0;
+		virtual void Statistics(BulkLoaderStats&) = 0;
+		virtual void Errors(std::vector<BatchError>&) = 0;
+
+		virtual IBulkLoader* AddRef() = 0;
+		virtual void Release() = 0;
+
+		virtual ~IBulkLoader() { };
+	};
+
+	/* Class TraceEvent describes a call of the client library to an
+	 * ITraceObserver. The object is the handle of the attachment, transaction,
+	 * statement, blob or service the call is about (set by the call itself
+	 * for the ones which allocate it). The sql is the text of the statement
+	 * prepared, executed or fetched, when known, else 0. The bytes are those
+	 * of the parameters sent and of the values received, or of the blob
+	 * segment or array slice. After the call, nanoseconds is its duration and
+	 * failed whether it returned an error. */
+
+	class TraceEvent
+	{
+	public:
+		TOP op;
+		uintptr_t object;
+		const char* sql;
+		int64_t bytes;
+		int64_t nanoseconds;
+		bool failed;
+
+		TraceEvent() : op(toCreateDatabase), object(0), sql(0), bytes(0),
+			nanoseconds(0), failed(false) { }
+	};
+
+	/* ITraceObserver is told about each call of the client library, from the
+	 * thread which makes it, once SetTraceObserver() registered it : Before()
+	 * and After() the call, with the same event. It is not owned by IBPP :
+	 * SetTraceObserver() returns once the calls which may still use the
+	 * previous observer are done, after which it may go. So it must not be
+	 * called from Before() or After(). What it throws is ignored. Without an
+	 * observer, the calls go straight to the library, as if tracing did not
+	 * exist. */
+
+	class ITraceObserver
+	{
+	public:
+		virtual void Before(const TraceEvent&) = 0;
+		virtual void After(const TraceEvent&) = 0;
+
+		virtual ~ITraceObserver() { };
+	};
+
+	/* Class LatencySummary sums up one histogram of a QueryStats : the count
+	 * of calls, their total and mean duration, some percentiles and the
+	 * longest one, all in microseconds. The percentiles come from the buckets
+	 * of the histogram and may be up to 12.5% above the exact value. */
+
+	class LatencySummary
+	{
+	public:
+		int64_t count;
+		double totalUs;
+		double meanUs;
+		double p50Us;
+		double p90Us;
+		double p99Us;
+		double maxUs;
+
+		LatencySummary() : count(0), totalUs(0), meanUs(0), p50Us(0),
+			p90Us(0), p99Us(0), maxUs(0) { }
+	};
+
+	/* Class QueryStats is what QueryStatsSnapshot() reports for each SQL
+	 * fingerprint : the text of the statements with the literals replaced by
+	 * '?' (a list of them by a single one), the comments dropped, a space only
+	 * between two words and the keywords and names in uppercase, so that the
+	 * same query, written with other values or spacing, counts as one. The
+	 * fetches are the calls of Fetch() and FetchBatch(), the affected rows
+	 * those of the inserts, updates and deletes, as AffectedRows() tells after
+	 * each Execute(). */
+
+	class QueryStats
+	{
+	public:
+		std::string fingerprint;
+		uint64_t hash;				// 64 bits FNV-1a of the fingerprint
+		LatencySummary prepare;
+		LatencySummary execute;
+		LatencySummary fetch;
+		int64_t rowsFetched;
+		int64_t rowsAffected;
+
+		QueryStats() : hash(0), rowsFetched(0), rowsAffected(0) { }
+	};
+
+#ifdef IBPP_COROUTINES
+	/* With C++20 coroutines, co_await Await(executor, future) suspends the
+	 * coroutine until the work behind the future is done, then resumes it on
+	 * the executor thread, where it may keep using the attachment. Should the
+	 * coroutine drop the last reference to the executor, the executor thread
+	 * finishes the work queued and then deletes it. */
+
+	template <class T>
+	class Awaitable
+	{
+	private:
+		IExecutor* mExecutor;
+		std::future<T> mFuture;
+
+	public:
+		bool await_ready() const
+			{ return mFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+		// Work runs in order : this runs once the awaited one is done
+		void await_suspend(std::coroutine_handle<> h)
+			{ mExecutor->Run([h]() { h.resume(); }); }
+		T await_resume() { return mFuture.get(); }
+
+		Awaitable(IExecutor* ex, std::future<T>&& f) : mExecutor(ex), mFuture(std::move(f)) { }
+	};
+
+	template <class T>
+	inline Awaitable<T> Await(const Executor& ex, std::future<T>&& f)
+		{ return Awaitable<T>(ex.intf(), std::move(f)); }
+#endif
+
 	/* Class EventInterface is merely a pure interface.
 	 * It is _not_ implemented by IBPP. It is only a base class definition from
 	 * which your own event interface classes have to derive from.
@@ -874,7 +1569,8 @@ namespace IBPP
 		{ return DatabaseFactory(ServerName, DatabaseName, UserName, UserPassword, "", "", ""); }
 
 	Transaction TransactionFactory(Database db, TAM am = amWrite,
-		TIL il = ilConcurrency, TLR lr = lrWait, TFF flags = TFF(0));
+		TIL il = ilConcurrency, TLR lr = lrWait, TFF flags = TFF(0),
+			int LockTimeout = 0);
 
 	Statement StatementFactory(Database db, Transaction tr,
 		const std::string& sql);
@@ -888,6 +1584,68 @@ namespace IBPP
 	
 	Events EventsFactory(Database db);
 
+	DatabasePool DatabasePoolFactory(const std::string& ServerName,
+		const std::string& DatabaseName, const std::string& UserName,
+			const std::string& UserPassword, const std::string& RoleName,
+				const std::string& CharSet, int MinSize, int MaxSize,
+					int IdleSeconds = 300,
+						const std::vector<std::string>& WarmSql = std::vector<std::string>());
+
+	Executor ExecutorFactory(Database db);
+
+	ParallelScan ParallelScanFactory(Database db, const std::string& sql,
+		const std::string& key, int parts, PSO order = psUnordered);
+
+	BulkLoader BulkLoaderFactory(Database db, const std::string& sql,
+		int parts, int commitRows = 10000, int commitMs = 1000,
+			int64_t memoryBudget = 64 * 1024 * 1024);
+
+	/* Retry() starts the transaction, runs the work and commits. When that
+	 * fails on a lock conflict, deadlock, update conflict or lock timeout, the
+	 * transaction is rolled back and everything runs again after a pause,
+	 * doubled each time, as the policy allows. Otherwise, or once the policy
+	 * gives up, the exception is thrown after the rollback. Returns the count
+	 * of runs. RetryStatistics() counts, over all the Retry() calls of the
+	 * process, the runs, the conflicts, the retries and the calls which gave
+	 * up on a conflict. */
+
+	int Retry(Transaction tr, const std::function<void()>& work,
+		const RetryPolicy& policy = RetryPolicy());
+
+	void RetryStatistics(int64_t* Runs, int64_t* Conflicts, int64_t* Retries,
+		int64_t* Failures);
+
+	void SetTraceObserver(ITraceObserver* observer);	// 0 to stop tracing
+
+	/* Once EnableQueryStats(true) is called, each Statement times its
+	 * Prepare(), Execute() and Fetch() calls in the histograms of its SQL
+	 * fingerprint, shared by the whole process. QueryStatsSnapshot() copies
+	 * them, by decreasing total time of execution, for QueryStatsText() or
+	 * QueryStatsJson() to format. ResetQueryStats() zeroes them all, to
+	 * start a new period of observation. Counting the affected rows costs
+	 * one more isc_dsql_sql_info() call per execution of the statements which
+	 * change data, nothing is counted or timed while the stats are off. */
+
+	void EnableQueryStats(bool on);
+	void QueryStatsSnapshot(std::vector<QueryStats>& stats);
+	void ResetQueryStats();
+	std::string QueryStatsText(const std::vector<QueryStats>& stats);
+	std::string QueryStatsJson(const std::vector<QueryStats>& stats);
+	std::string QueryFingerprint(const std::string& sql);
+
+	/* ParsePlan() reads the text of Statement::Plan() into a tree. Once
+	 * SetPlanPolicy() is called, the Prepare() of each new SQL fingerprint
+	 * also asks for the plan (one more isc_dsql_sql_info() call), records it
+	 * for PlanCapture() and calls the alert of the policy, from the thread
+	 * which prepares, on what it finds. What the alert throws is ignored.
+	 * SetPlanPolicy() starts anew with no plan captured, ClearPlanPolicy()
+	 * stops the checks. */
+
+	void ParsePlan(const std::string& text, std::vector<PlanNode>& plans);
+	void SetPlanPolicy(const PlanPolicy& policy);
+	void ClearPlanPolicy();
+	void PlanCapture(std::map<std::string, std::string>& plans);
+
 	/* IBPP uses a self initialization system. Each time an object that may
 	 * require the usage of the Interbase client C-API library is used, the
 	 * library internal handling details are automatically initialized, if not
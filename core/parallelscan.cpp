@@ -0,0 +1,390 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, ParallelScan class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <cctype>
+
+using namespace ibpp_internals;
+
+//	How far each range may get ahead of the reading thread
+const int ParallelScanImpl::MAXROWS = 256;
+const int ParallelScanImpl::MAXBATCHES = 4;
+
+//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
+
+void ParallelScanImpl::SetRange(int64_t low, int64_t high)
+{
+	if (mStarted)
+		throw LogicExceptionImpl("ParallelScan::SetRange", _("The scan is already started."));
+
+	mLow = low;
+	mHigh = high;
+	mRangeSet = true;
+}
+
+bool ParallelScanImpl::Fetch(IBPP::Row& row)
+{
+	if (! mStarted) Start(0);
+	else if (mBatchRows != 0)
+		throw LogicExceptionImpl("ParallelScan::Fetch",
+			_("The scan is read by FetchBatch()."));
+
+	row.clear();
+	std::exception_ptr error;
+	std::unique_lock<std::mutex> guard(mLock);
+	int r = Ready(guard, error);
+	if (r < 0)
+	{
+		guard.unlock();
+		Close();
+		if (error) std::rethrow_exception(error);
+		return false;
+	}
+
+	row = std::move(mRanges[r].rows.front());
+	mRanges[r].rows.pop_front();
+	mEmptied.notify_all();
+	return true;
+}
+
+int ParallelScanImpl::FetchBatch(IBPP::ColumnBatch& batch, int rows)
+{
+	if (rows <= 0)
+		throw LogicExceptionImpl("ParallelScan::FetchBatch",
+			_("The count of rows to fetch must be positive."));
+	if (! mStarted) Start(rows);
+	else if (mBatchRows == 0)
+		throw LogicExceptionImpl("ParallelScan::FetchBatch",
+			_("The scan is read by Fetch()."));
+
+	std::exception_ptr error;
+	std::unique_lock<std::mutex> guard(mLock);
+	int r = Ready(guard, error);
+	if (r < 0)
+	{
+		guard.unlock();
+		Close();
+		if (error) std::rethrow_exception(error);
+		batch.Clear();
+		return 0;
+	}
+
+	batch.Swap(mRanges[r].batches.front());
+	mRanges[r].batches.pop_front();
+	mEmptied.notify_all();
+	return batch.Rows();
+}
+
+void ParallelScanImpl::Close()
+{
+	Stop();
+	mStarted = true;	// Nothing more to read
+}
+
+IBPP::IParallelScan* ParallelScanImpl::AddRef()
+{
+	ASSERTION(mRefCount >= 0);
+	++mRefCount;
+	return this;
+}
+
+void ParallelScanImpl::Release()
+{
+	// Release cannot throw, except in DEBUG builds on assertion
+	ASSERTION(mRefCount >= 0);
+	try { if (--mRefCount <= 0) delete this; }
+		catch (...) { }
+}
+
+//	(((((((( OBJECT INTERNAL METHODS ))))))))
+
+void ParallelScanImpl::Start(int batchRows)
+{
+	if (! mRangeSet)
+	{
+		if (! mDatabase->Connected())
+			throw LogicExceptionImpl("ParallelScan",
+				_("Without SetRange(), the Database must be connected to query the key range."));
+
+		IBPP::Transaction tr = IBPP::TransactionFactory(mDatabase, IBPP::amRead);
+		tr->Start();
+		IBPP::Statement st = IBPP::StatementFactory(mDatabase, tr);
+		st->Execute("select min(" + mKey + "), max(" + mKey + ") from ("
+			+ mSql + ") ibpp_scan");
+		mLow = 0;
+		mHigh = -1;		// Empty, unless the query returns something
+		if (st->Fetch() && ! st->IsNull(1))
+		{
+			st->Get(1, mLow);
+			st->Get(2, mHigh);
+		}
+		st->Close();
+		tr->Commit();
+	}
+
+	mStarted = true;
+	mBatchRows = batchRows;
+	mNext = 0;
+	if (mLow > mHigh) return;	// No range, nothing to read
+
+	// Range i goes from bounds i to i+1, excluded. The bounds are computed
+	// in unsigned arithmetic : high - low may not fit an int64_t. The first
+	// span % parts ranges get one more key than the others.
+	const uint64_t span = (uint64_t)mHigh - (uint64_t)mLow;
+	const uint64_t parts = (uint64_t)mParts;
+	mRanges.resize(mParts);
+	for (int i = 0; i < mParts; i++)
+	{
+		Range& range = mRanges[i];
+		const uint64_t extra = (uint64_t)i < span % parts ? (uint64_t)i : span % parts;
+		range.low = (int64_t)((uint64_t)mLow + span / parts * (uint64_t)i + extra);
+		if (i > 0) mRanges[i-1].high = range.low - 1;
+		range.done = false;
+	}
+	mRanges[mParts-1].high = mHigh;
+
+	try
+	{
+		for (int i = 0; i < mParts; i++)
+			mThreads.push_back(std::thread(&ParallelScanImpl::Scan, this, i));
+	}
+	catch (...)
+	{
+		Stop();
+		throw;
+	}
+}
+
+void ParallelScanImpl::Scan(int r)
+{
+	// Thread of range r. Its attachment, transaction and statement are its
+	// own, only the queued rows or batches go to the reading thread.
+	try
+	{
+		IBPP::Database db = dynamic_cast<DatabaseImpl*>(mDatabase.intf())->Clone();
+		IBPP::Transaction tr = IBPP::TransactionFactory(db, IBPP::amRead,
+			IBPP::ilConcurrency);
+		tr->Start();
+
+		std::string sql = "select * from (" + mSql + ") ibpp_scan where "
+			+ mKey + " between ? and ?";
+		if (mOrder == IBPP::psByKey) sql += " order by " + mKey;
+		IBPP::Statement st = IBPP::StatementFactory(db, tr, sql);
+		st->Set(1, mRanges[r].low);
+		st->Set(2, mRanges[r].high);
+		st->Execute();
+
+		if (mBatchRows == 0)
+		{
+			IBPP::Row row;
+			while (st->Fetch(row))
+				if (! Queue(r, row)) break;
+		}
+		else
+		{
+			IBPP::ColumnBatch batch;
+			while (st->FetchBatch(batch, mBatchRows) > 0)
+				if (! Queue(r, batch)) break;
+		}
+
+		st->Close();
+		tr->Commit();
+		db->Disconnect();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		mRanges[r].error = std::current_exception();
+	}
+
+	std::lock_guard<std::mutex> guard(mLock);
+	mRanges[r].done = true;
+	mFilled.notify_one();
+}
+
+bool ParallelScanImpl::Queue(int r, IBPP::Row& row)
+{
+	// Hands the row over, returns false when the scan is stopping. The row
+	// outlives the attachment of this thread : it forgets it, so that its
+	// blobs and arrays throw instead of using a dead attachment.
+	RowImpl* impl = dynamic_cast<RowImpl*>(row.intf());
+	impl->SetTransaction(0);
+	impl->SetDatabase(0);
+
+	std::unique_lock<std::mutex> guard(mLock);
+	while ((int)mRanges[r].rows.size() >= MAXROWS && ! mStopping)
+		mEmptied.wait(guard);
+	if (mStopping) return false;
+	mRanges[r].rows.push_back(std::move(row));
+	mFilled.notify_one();
+	return true;
+}
+
+bool ParallelScanImpl::Queue(int r, IBPP::ColumnBatch& batch)
+{
+	std::unique_lock<std::mutex> guard(mLock);
+	while ((int)mRanges[r].batches.size() >= MAXBATCHES && ! mStopping)
+		mEmptied.wait(guard);
+	if (mStopping) return false;
+	mRanges[r].batches.push_back(IBPP::ColumnBatch());
+	mRanges[r].batches.back().Swap(batch);
+	mFilled.notify_one();
+	return true;
+}
+
+bool ParallelScanImpl::Queued(const Range& range) const
+{
+	return mBatchRows == 0 ? ! range.rows.empty() : ! range.batches.empty();
+}
+
+int ParallelScanImpl::Ready(std::unique_lock<std::mutex>& guard,
+	std::exception_ptr& error)
+{
+	// Called with mLock held. Returns a range with something queued, waiting
+	// for one if need be. Returns -1 once all the ranges are read, or when one
+	// of them failed, after the rows it queued before failing (error is set).
+
+	const int n = (int)mRanges.size();
+	for (;;)
+	{
+		if (mOrder == IBPP::psByKey)
+		{
+			// The ranges are read in turn, each one sorted
+			while (mNext < n && mRanges[mNext].done && ! Queued(mRanges[mNext]))
+			{
+				if (mRanges[mNext].error)
+				{
+					error = mRanges[mNext].error;
+					return -1;
+				}
+				++mNext;
+			}
+			if (mNext == n) return -1;
+			if (Queued(mRanges[mNext])) return mNext;
+		}
+		else
+		{
+			// The ranges are looked at in turn, so that none lags behind
+			int finished = 0;
+			for (int i = 0; i < n; i++)
+			{
+				int r = (mNext + i) % n;
+				if (Queued(mRanges[r]))
+				{
+					mNext = (r + 1) % n;
+					return r;
+				}
+				if (mRanges[r].error)
+				{
+					error = mRanges[r].error;
+					return -1;
+				}
+				if (mRanges[r].done) ++finished;
+			}
+			if (finished == n) return -1;
+		}
+		mFilled.wait(guard);
+	}
+}
+
+void ParallelScanImpl::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		mStopping = true;
+	}
+	mEmptied.notify_all();
+
+	// Each thread closes its own attachment before ending
+	for (unsigned i = 0; i < mThreads.size(); i++)
+		mThreads[i].join();
+	mThreads.clear();
+	mRanges.clear();
+	mNext = 0;
+}
+
+ParallelScanImpl::ParallelScanImpl(IBPP::Database db, const std::string& sql,
+	const std::string& key, int parts, IBPP::PSO order)
+	: mRefCount(0), mDatabase(db), mSql(sql), mKey(key), mParts(parts),
+	mOrder(order), mRangeSet(false), mLow(0), mHigh(-1), mStarted(false),
+	mBatchRows(0), mNext(0), mStopping(false)
+{
+	if (db.intf() == 0)
+		throw LogicExceptionImpl("ParallelScan", _("No Database given."));
+	if (sql.empty() || key.empty())
+		throw LogicExceptionImpl("ParallelScan", _("Both a SELECT and a key are needed."));
+	if (parts < 1)
+		throw LogicExceptionImpl("ParallelScan", _("Invalid count of ranges %d."), parts);
+
+	// The key goes into the SQL text : it must be one column name, which is
+	// then quoted (a regular identifier being stored in upper case).
+	bool valid;
+	if (key[0] == '"')
+	{
+		valid = key.length() >= 3 && key[key.length()-1] == '"';
+		for (size_t i = 1; valid && i < key.length() - 1; i++)
+			if (key[i] == '"' && (i + 2 >= key.length() || key[++i] != '"'))
+				valid = false;
+		if (valid) mKey = key;
+	}
+	else
+	{
+		valid = isalpha((unsigned char)key[0]) != 0;
+		mKey = "\"";
+		for (size_t i = 0; valid && i < key.length(); i++)
+		{
+			unsigned char c = (unsigned char)key[i];
+			valid = isalnum(c) || c == '_' || c == '$';
+			mKey += (char)toupper(c);
+		}
+		mKey += '"';
+	}
+	if (! valid)
+		throw LogicExceptionImpl("ParallelScan",
+			_("The key must be a single column name, not '%s'."), key.c_str());
+}
+
+ParallelScanImpl::~ParallelScanImpl()
+{
+	try { Stop(); }
+		catch (...) { }
+}
+
+//
+//	EOF
+//
@@ -0,0 +1,412 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, execution plan parser and PlanPolicy implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <cctype>
+
+using namespace ibpp_internals;
+
+namespace
+{
+	//	The policy of IBPP::SetPlanPolicy() and the plans captured under it
+	std::mutex planLock;
+	std::shared_ptr<IBPP::PlanPolicy> planPolicy;
+	std::map<std::string, std::string> planCaptured;	// By fingerprint
+	std::atomic<bool> planPolicyOn(false);
+
+	//	Set while checking, so that the queries of the check are not checked
+	thread_local bool planChecking = false;
+
+	//	Tokens of a plan : words (names and keywords), '(', ')' and ','
+	class PlanReader
+	{
+		const std::string& mText;
+		size_t mPos;
+
+	public:
+		std::string Next()
+		{
+			while (mPos < mText.length() && isspace((unsigned char)mText[mPos])) mPos++;
+			if (mPos >= mText.length()) return std::string();
+			const char c = mText[mPos];
+			if (c == '(' || c == ')' || c == ',') return std::string(1, mText[mPos++]);
+			size_t start = mPos;
+			if (c == '"')
+			{
+				size_t end = mText.find('"', mPos + 1);
+				mPos = end == std::string::npos ? mText.length() : end + 1;
+			}
+			else while (mPos < mText.length() && ! isspace((unsigned char)mText[mPos])
+					&& mText[mPos] != '(' && mText[mPos] != ')' && mText[mPos] != ',')
+				mPos++;
+			return mText.substr(start, mPos - start);
+		}
+
+		std::string Peek()
+		{
+			size_t pos = mPos;
+			std::string token = Next();
+			mPos = pos;
+			return token;
+		}
+
+		void Expect(const char* token)
+		{
+			std::string next = Next();
+			if (next != token)
+				throw LogicExceptionImpl("IBPP::ParsePlan",
+					_("'%s' expected instead of '%s' at offset %d of the plan."),
+						token, next.c_str(), (int)mPos);
+		}
+
+		PlanReader(const std::string& text) : mText(text), mPos(0) { }
+	};
+
+	void readNames(PlanReader& reader, std::vector<std::string>& names)
+	{
+		reader.Expect("(");
+		for (;;)
+		{
+			names.push_back(reader.Next());
+			if (reader.Peek() != ",") break;
+			reader.Next();
+		}
+		reader.Expect(")");
+	}
+
+	void readNode(PlanReader& reader, IBPP::PlanNode& node);
+
+	void readList(PlanReader& reader, IBPP::PlanNode& node)
+	{
+		reader.Expect("(");
+		for (;;)
+		{
+			node.children.push_back(IBPP::PlanNode());
+			readNode(reader, node.children.back());
+			if (reader.Peek() != ",") break;
+			reader.Next();
+		}
+		reader.Expect(")");
+	}
+
+	void readNode(PlanReader& reader, IBPP::PlanNode& node)
+	{
+		std::string token = reader.Peek();
+		if (token == "JOIN" || token == "SORT" || token == "MERGE" || token == "HASH")
+		{
+			reader.Next();
+			node.type = token == "JOIN" ? IBPP::pnJoin : token == "SORT" ? IBPP::pnSort
+				: token == "MERGE" ? IBPP::pnMerge : IBPP::pnHash;
+			readList(reader, node);
+			return;
+		}
+		if (token == "(")
+		{
+			// Streams in parentheses, joined when there are several of them
+			node.type = IBPP::pnJoin;
+			readList(reader, node);
+			if (node.children.size() == 1)
+			{
+				IBPP::PlanNode single = node.children[0];
+				node = single;
+			}
+			return;
+		}
+
+		// A relation : its name (after those of the views it comes from), then
+		// the way it is read
+		for (;;)
+		{
+			token = reader.Next();
+			if (token.empty() || token == "(" || token == ")" || token == ",")
+				throw LogicExceptionImpl("IBPP::ParsePlan",
+					_("Unexpected end of the access to '%s' in the plan."),
+						node.relation.c_str());
+			if (token == "NATURAL")
+			{
+				node.type = IBPP::pnNatural;
+				return;
+			}
+			if (token == "INDEX")
+			{
+				node.type = IBPP::pnIndex;
+				readNames(reader, node.indexes);
+				return;
+			}
+			if (token == "ORDER")
+			{
+				node.type = IBPP::pnOrder;
+				node.order = reader.Next();
+				if (reader.Peek() == "INDEX")
+				{
+					reader.Next();
+					readNames(reader, node.indexes);
+				}
+				return;
+			}
+			if (! node.relation.empty()) node.relation += ' ';
+			node.relation += token;
+		}
+	}
+
+	//	The natural scans of a plan
+	void naturalScans(const IBPP::PlanNode& node, std::vector<std::string>& relations)
+	{
+		if (node.type == IBPP::pnNatural) relations.push_back(node.relation);
+		for (size_t i = 0; i < node.children.size(); i++)
+			naturalScans(node.children[i], relations);
+	}
+
+	//	The relation an alias stands for in the text of the statement : the
+	//	relation named after FROM or JOIN (or a comma of the FROM list) which
+	//	the alias follows ('CUSTOMERS C' or 'CUSTOMERS AS C'), if any.
+	std::string aliasedRelation(const std::string& sql, const std::string& alias)
+	{
+		// Words in upper case, quoted identifiers without their quotes, the
+		// other characters one by one, string constants and comments dropped
+		std::vector<std::string> words;
+		std::string word;
+		for (size_t i = 0; i <= sql.length(); i++)
+		{
+			const char c = i < sql.length() ? sql[i] : ' ';
+			if (isalnum((unsigned char)c) || c == '_' || c == '$')
+			{
+				word += (char)toupper((unsigned char)c);
+				continue;
+			}
+			if (! word.empty()) words.push_back(word);
+			word.clear();
+
+			size_t end = i;
+			if (c == '"' || c == '\'')
+			{
+				end = sql.find(c, i + 1);
+				if (end == std::string::npos) end = sql.length();
+				// Quoted identifiers keep their leading quote to be told apart
+				if (c == '"') words.push_back(sql.substr(i, end - i));
+				else words.push_back("'");
+			}
+			else if (c == '-' && i + 1 < sql.length() && sql[i+1] == '-')
+			{
+				end = sql.find('\n', i);
+				if (end == std::string::npos) end = sql.length();
+			}
+			else if (c == '/' && i + 1 < sql.length() && sql[i+1] == '*')
+			{
+				end = sql.find("*/", i + 2);
+				end = end == std::string::npos ? sql.length() : end + 1;
+			}
+			else if (! isspace((unsigned char)c)) words.push_back(std::string(1, c));
+			i = end;
+		}
+
+		bool from = false;		// In a FROM list, where commas separate relations
+		int depth = 0;			// Parentheses, the FROM list being at its own
+		int fromDepth = 0;
+		for (size_t i = 0; i + 1 < words.size(); i++)
+		{
+			const std::string& w = words[i];
+			if (w == "(") { ++depth; continue; }
+			if (w == ")") { if (--depth < fromDepth) from = false; continue; }
+			if (w == "WHERE" || w == "GROUP" || w == "HAVING" || w == "ORDER"
+				|| w == "PLAN" || w == "UNION" || w == "ROWS")
+			{
+				if (depth <= fromDepth) from = false;
+				continue;
+			}
+			if (w == "FROM" || w == "JOIN") { from = true; fromDepth = depth; }
+			else if (! (w == "," && from && depth == fromDepth)) continue;
+
+			// A relation, or a procedure with its arguments
+			size_t n = i + 1;
+			std::string name = words[n];
+			if (name[0] == '"') name.erase(0, 1);
+			else if (! isalpha((unsigned char)name[0])) continue;
+			if (n + 1 < words.size() && words[n+1] == "(")
+				for (int level = 0; ++n < words.size(); )
+				{
+					if (words[n] == "(") ++level;
+					else if (words[n] == ")" && --level == 0) break;
+				}
+			if (++n < words.size() && words[n] == "AS") ++n;
+			if (n + 1 < words.size() && words[n+1] == ".") continue;	// alias.column
+			if (n < words.size() && (words[n] == alias || words[n] == '"' + alias))
+				return name;
+		}
+		return std::string();
+	}
+}
+
+void IBPP::ParsePlan(const std::string& text, std::vector<IBPP::PlanNode>& plans)
+{
+	plans.clear();
+	PlanReader reader(text);
+	for (;;)
+	{
+		std::string token = reader.Next();
+		if (token.empty()) break;
+		if (token != "PLAN")
+			throw LogicExceptionImpl("IBPP::ParsePlan",
+				_("'PLAN' expected instead of '%s'."), token.c_str());
+
+		plans.push_back(IBPP::PlanNode());
+		IBPP::PlanNode& plan = plans.back();
+		if (reader.Peek() == "(") readList(reader, plan);
+		else
+		{
+			plan.children.push_back(IBPP::PlanNode());
+			readNode(reader, plan.children.back());
+		}
+
+		token = reader.Peek();
+		if (! token.empty() && token != "PLAN")
+			throw LogicExceptionImpl("IBPP::ParsePlan",
+				_("Unexpected '%s' in the plan."), token.c_str());
+	}
+}
+
+void IBPP::SetPlanPolicy(const IBPP::PlanPolicy& policy)
+{
+	std::lock_guard<std::mutex> guard(planLock);
+	planPolicy = std::make_shared<IBPP::PlanPolicy>(policy);
+	planCaptured.clear();
+	planPolicyOn.store(true);
+}
+
+void IBPP::ClearPlanPolicy()
+{
+	std::lock_guard<std::mutex> guard(planLock);
+	planPolicyOn.store(false);
+	planPolicy.reset();
+}
+
+void IBPP::PlanCapture(std::map<std::string, std::string>& plans)
+{
+	plans.clear();
+	std::lock_guard<std::mutex> guard(planLock);
+	std::map<std::string, std::string>::const_iterator it;
+	for (it = planCaptured.begin(); it != planCaptured.end(); ++it)
+		if (! it->second.empty()) plans.insert(*it);
+}
+
+//	(((((((( StatementImpl ))))))))
+
+void StatementImpl::PlanCheck()
+{
+	// Once per new fingerprint while a policy is set. A plan which can't be
+	// read or checked is simply not reported, the Prepare() still succeeds.
+	if (! planPolicyOn.load() || planChecking) return;
+	if (mType != IBPP::stSelect && mType != IBPP::stSelectUpdate
+		&& mType != IBPP::stInsert && mType != IBPP::stUpdate
+		&& mType != IBPP::stDelete && mType != IBPP::stExecProcedure) return;
+
+	const std::string fingerprint = QueryProfile::Fingerprint(mSql);
+	std::shared_ptr<IBPP::PlanPolicy> policy;
+	{
+		std::lock_guard<std::mutex> guard(planLock);
+		if (! planPolicy || planCaptured.count(fingerprint) != 0) return;
+		policy = planPolicy;
+		planCaptured[fingerprint];		// Taken, no other thread checks it
+	}
+
+	planChecking = true;
+	try
+	{
+		std::string text;
+		Plan(text);
+		if (! text.empty())
+		{
+			{
+				std::lock_guard<std::mutex> guard(planLock);
+				if (planPolicy == policy) planCaptured[fingerprint] = text;
+			}
+
+			std::vector<IBPP::PlanAlert> alerts;
+			IBPP::PlanAlert alert;
+			alert.sql = mSql;
+			alert.fingerprint = fingerprint;
+			alert.plan = text;
+
+			std::map<std::string, std::string>::const_iterator base =
+				policy->baseline.find(fingerprint);
+			if (base != policy->baseline.end() && base->second != text)
+			{
+				alert.kind = IBPP::paPlanChanged;
+				alert.previous = base->second;
+				alerts.push_back(alert);
+				alert.previous.clear();
+			}
+
+			if (policy->naturalRows >= 0)
+			{
+				std::vector<IBPP::PlanNode> plans;
+				IBPP::ParsePlan(text, plans);
+				std::vector<std::string> scans;
+				for (size_t i = 0; i < plans.size(); i++) naturalScans(plans[i], scans);
+				for (size_t i = 0; i < scans.size(); i++)
+				{
+					// The last name is the relation itself, or its alias
+					std::string name = scans[i].substr(scans[i].rfind(' ') + 1);
+					int64_t rows = mDatabase->RelationRows(name);
+					if (rows < 0)
+					{
+						std::string relation = aliasedRelation(mSql, name);
+						if (! relation.empty()) rows = mDatabase->RelationRows(relation);
+					}
+					if (policy->naturalRows == 0 || rows > policy->naturalRows)
+					{
+						alert.kind = IBPP::paNaturalScan;
+						alert.relation = scans[i];
+						alert.rows = rows;
+						alerts.push_back(alert);
+					}
+				}
+			}
+
+			if (policy->alert)
+				for (size_t i = 0; i < alerts.size(); i++)
+					try { policy->alert(alerts[i]); } catch (...) { }
+		}
+	}
+	catch (...) { }
+	planChecking = false;
+}
+
+//
+//	EOF
+//
@@ -0,0 +1,441 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, per SQL fingerprint statistics (QueryStats)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+
+using namespace ibpp_internals;
+
+std::atomic<bool> QueryProfile::mEnabled(false);
+
+namespace
+{
+	//	Beyond this count of fingerprints, the statements share one profile
+	const int MAXQUERIES = 1000;
+	const char* const OVERFLOW_FINGERPRINT = "(other statements)";
+
+	//	All the profiles, by fingerprint. Only used on the first Prepare()
+	//	or Execute() of a statement, the timings go to the profile directly.
+	std::mutex& registryLock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+
+	std::map<std::string, QueryProfile*>& registry()
+	{
+		static std::map<std::string, QueryProfile*> profiles;
+		return profiles;
+	}
+
+	bool wordChar(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+			|| (c >= '0' && c <= '9') || c == '_' || c == '$';
+	}
+
+	bool digitChar(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	//	The keywords after which an operator or a signed number may come :
+	//	'- 1' after them is the number -1, after a column it's a subtraction
+	bool keyword(const std::string& word)
+	{
+		static const char* const keywords[] = {"AND", "BETWEEN", "BY", "CASE",
+			"ELSE", "EXISTS", "FIRST", "FROM", "HAVING", "IN", "IS", "LIKE",
+			"NOT", "ON", "OR", "RETURN", "ROWS", "SELECT", "SET", "SKIP",
+			"THEN", "TO", "VALUES", "WHEN", "WHERE"};
+		for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
+			if (word == keywords[i]) return true;
+		return false;
+	}
+
+	void appendText(std::string& out, const char* format, ...)
+	{
+		char buffer[256];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		out.append(buffer);
+	}
+
+	void appendJson(std::string& out, const char* name, const IBPP::LatencySummary& s)
+	{
+		appendText(out, "\"%s\":{\"count\":%lld,\"totalUs\":%.1f,\"meanUs\":%.1f,"
+			"\"p50Us\":%.1f,\"p90Us\":%.1f,\"p99Us\":%.1f,\"maxUs\":%.1f}",
+			name, (long long)s.count, s.totalUs, s.meanUs, s.p50Us, s.p90Us,
+			s.p99Us, s.maxUs);
+	}
+
+	bool slowerFirst(const IBPP::QueryStats& a, const IBPP::QueryStats& b)
+	{
+		return a.execute.totalUs > b.execute.totalUs;
+	}
+}
+
+//
+//	LatencyHistogram
+//
+
+int LatencyHistogram::Bucket(int64_t ns)
+{
+	if (ns < LINEAR) return ns < 0 ? 0 : (int)ns;
+
+	// The power of two gives the group, the next 3 bits the bucket in it
+	int exponent = 4;
+	while (exponent < 62 && (ns >> (exponent + 1)) != 0) exponent++;
+	const int bucket = LINEAR + (exponent - 4) * SUBS
+		+ (int)((ns >> (exponent - 3)) & (SUBS - 1));
+	return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+int64_t LatencyHistogram::Highest(int bucket)
+{
+	if (bucket < LINEAR) return bucket;
+	const int exponent = 4 + (bucket - LINEAR) / SUBS;
+	const int64_t sub = (bucket - LINEAR) % SUBS;
+	return ((SUBS + sub + 1) << (exponent - 3)) - 1;
+}
+
+void LatencyHistogram::Record(int64_t ns)
+{
+	mCounts[Bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+	mTotal.fetch_add(ns, std::memory_order_relaxed);
+	int64_t max = mMax.load(std::memory_order_relaxed);
+	while (ns > max && ! mMax.compare_exchange_weak(max, ns,
+		std::memory_order_relaxed)) { }
+}
+
+void LatencyHistogram::Summary(IBPP::LatencySummary& summary) const
+{
+	// The counts are read once, while they may still be going up : the
+	// percentiles are taken from that very copy so that they stay coherent.
+	int64_t counts[BUCKETS];
+	int64_t count = 0;
+	int b;
+	for (b = 0; b < BUCKETS; b++)
+		count += counts[b] = mCounts[b].load(std::memory_order_relaxed);
+
+	summary = IBPP::LatencySummary();
+	if (count == 0) return;
+
+	const int64_t max = mMax.load(std::memory_order_relaxed);
+	summary.count = count;
+	summary.totalUs = mTotal.load(std::memory_order_relaxed) / 1000.0;
+	summary.meanUs = summary.totalUs / count;
+	summary.maxUs = max / 1000.0;
+
+	const double percents[3] = {0.50, 0.90, 0.99};
+	double* values[3] = {&summary.p50Us, &summary.p90Us, &summary.p99Us};
+	int64_t seen = 0;
+	int p = 0;
+	for (b = 0; b < BUCKETS && p < 3; b++)
+	{
+		seen += counts[b];
+		while (p < 3 && seen > 0 && seen >= (int64_t)(percents[p] * count + 0.999999))
+			*values[p++] = std::min(Highest(b), max) / 1000.0;
+	}
+	while (p < 3) *values[p++] = summary.maxUs;
+}
+
+void LatencyHistogram::Reset()
+{
+	for (int b = 0; b < BUCKETS; b++) mCounts[b].store(0, std::memory_order_relaxed);
+	mTotal.store(0, std::memory_order_relaxed);
+	mMax.store(0, std::memory_order_relaxed);
+}
+
+//
+//	QueryProfile
+//
+
+QueryProfile* QueryProfile::Find(const std::string& sql)
+{
+	std::string fingerprint = Fingerprint(sql);
+
+	std::lock_guard<std::mutex> guard(registryLock());
+	std::map<std::string, QueryProfile*>& profiles = registry();
+	std::map<std::string, QueryProfile*>::iterator it = profiles.find(fingerprint);
+	if (it != profiles.end()) return it->second;
+
+	if ((int)profiles.size() >= MAXQUERIES)
+	{
+		fingerprint = OVERFLOW_FINGERPRINT;
+		it = profiles.find(fingerprint);
+		if (it != profiles.end()) return it->second;
+	}
+	QueryProfile* profile = new QueryProfile(fingerprint);
+	profiles[fingerprint] = profile;
+	return profile;
+}
+
+std::string QueryProfile::Fingerprint(const std::string& sql)
+{
+	std::string out;
+	out.reserve(sql.length());
+	bool space = false;		// Whitespace or comment since the last token
+	std::string lastWord;	// The last keyword or identifier
+	const size_t length = sql.length();
+	size_t i = 0;
+	while (i < length)
+	{
+		const char c = sql[i];
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+		{
+			space = true;
+			i++;
+			continue;
+		}
+		if (c == '-' && i + 1 < length && sql[i+1] == '-')
+		{
+			i = sql.find('\n', i);
+			if (i == std::string::npos) i = length;
+			space = true;
+			continue;
+		}
+		if (c == '/' && i + 1 < length && sql[i+1] == '*')
+		{
+			i = sql.find("*/", i + 2);
+			i = i == std::string::npos ? length : i + 2;
+			space = true;
+			continue;
+		}
+
+		// A leading '+' or '-' is the sign of a number only where no operand
+		// comes before it : 'a-1' is not 'a' followed by '-1'.
+		const char last = out.empty() ? 0 : out[out.length()-1];
+		const bool operand = (wordChar(last) && ! keyword(lastWord))
+			|| last == '?' || last == '"' || last == ')';
+		std::string token;
+		bool literal = false;
+		if (c == '\'' || ((c == 'x' || c == 'X') && i + 1 < length && sql[i+1] == '\''))
+		{
+			// String literal, its quotes doubled inside
+			if (c != '\'') i++;
+			for (i++; i < length; i++)
+				if (sql[i] == '\'')
+				{
+					if (i + 1 < length && sql[i+1] == '\'') i++;
+					else break;
+				}
+			i++;
+			literal = true;
+		}
+		else if (c == '"')
+		{
+			// Quoted identifier, kept as it is
+			size_t end = sql.find('"', i + 1);
+			end = end == std::string::npos ? length : end + 1;
+			token.assign(sql, i, end - i);
+			i = end;
+		}
+		else if (digitChar(c) || (c == '.' && i + 1 < length && digitChar(sql[i+1]))
+			|| (! operand && (c == '-' || c == '+') && i + 1 < length
+				&& (digitChar(sql[i+1]) || sql[i+1] == '.')))
+		{
+			// Numeric literal, integer, decimal, float or hexadecimal
+			for (i++; i < length; i++)
+			{
+				const char n = sql[i];
+				if ((n == '+' || n == '-') && (sql[i-1] == 'e' || sql[i-1] == 'E')
+					&& digitChar(sql[i-2])) continue;
+				if (! wordChar(n) && n != '.') break;
+			}
+			literal = true;
+		}
+		else if (wordChar(c))
+		{
+			for (; i < length && wordChar(sql[i]); i++)
+				token += (char)toupper((unsigned char)sql[i]);
+		}
+		else token = sql[i++];
+
+		if (literal)
+		{
+			// A list of values counts as a single one, whatever its length
+			if (last == ',' && out.length() >= 2 && out[out.length()-2] == '?')
+			{
+				out.erase(out.length() - 1);
+				space = false;
+				continue;
+			}
+			token = "?";
+		}
+
+		// One space, only between two words : 'a=1' and 'a = 1' are the same
+		const char first = token[0];
+		if (space && (wordChar(last) || last == '?' || last == '"')
+			&& (wordChar(first) || first == '?' || first == '"'))
+			out += ' ';
+		space = false;
+		out += token;
+		if (wordChar(first)) lastWord = token;
+	}
+	return out;
+}
+
+uint64_t QueryProfile::Hash(const std::string& text)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < text.length(); i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+QueryProfile::QueryProfile(const std::string& fingerprint)
+	: mFingerprint(fingerprint), mHash(Hash(fingerprint)),
+	mRowsFetched(0), mRowsAffected(0)
+{
+}
+
+//
+//	Public functions
+//
+
+void IBPP::EnableQueryStats(bool on)
+{
+	QueryProfile::mEnabled.store(on);
+}
+
+void IBPP::QueryStatsSnapshot(std::vector<IBPP::QueryStats>& stats)
+{
+	stats.clear();
+	{
+		std::lock_guard<std::mutex> guard(registryLock());
+		std::map<std::string, QueryProfile*>& profiles = registry();
+		stats.reserve(profiles.size());
+		for (std::map<std::string, QueryProfile*>::iterator it = profiles.begin();
+			it != profiles.end(); ++it)
+		{
+			QueryProfile* profile = it->second;
+			IBPP::QueryStats s;
+			s.fingerprint = profile->mFingerprint;
+			s.hash = profile->mHash;
+			profile->mPrepare.Summary(s.prepare);
+			profile->mExecute.Summary(s.execute);
+			profile->mFetch.Summary(s.fetch);
+			s.rowsFetched = profile->mRowsFetched.load(std::memory_order_relaxed);
+			s.rowsAffected = profile->mRowsAffected.load(std::memory_order_relaxed);
+			if (s.prepare.count + s.execute.count + s.fetch.count > 0)
+				stats.push_back(s);
+		}
+	}
+	std::stable_sort(stats.begin(), stats.end(), slowerFirst);
+}
+
+void IBPP::ResetQueryStats()
+{
+	std::lock_guard<std::mutex> guard(registryLock());
+	std::map<std::string, QueryProfile*>& profiles = registry();
+	for (std::map<std::string, QueryProfile*>::iterator it = profiles.begin();
+		it != profiles.end(); ++it)
+	{
+		QueryProfile* profile = it->second;
+		profile->mPrepare.Reset();
+		profile->mExecute.Reset();
+		profile->mFetch.Reset();
+		profile->mRowsFetched.store(0, std::memory_order_relaxed);
+		profile->mRowsAffected.store(0, std::memory_order_relaxed);
+	}
+}
+
+std::string IBPP::QueryStatsText(const std::vector<IBPP::QueryStats>& stats)
+{
+	// One line of figures per fingerprint, its text on the next line
+	std::string out;
+	appendText(out, "%-16s %10s %10s %10s %10s %10s %10s %12s %10s\n",
+		"hash", "executes", "mean us", "p50 us", "p99 us", "max us",
+		"fetches", "rows", "affected");
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		const IBPP::QueryStats& s = stats[i];
+		appendText(out, "%016llx %10lld %10.1f %10.1f %10.1f %10.1f %10lld %12lld %10lld\n",
+			(unsigned long long)s.hash, (long long)s.execute.count,
+			s.execute.meanUs, s.execute.p50Us, s.execute.p99Us, s.execute.maxUs,
+			(long long)s.fetch.count, (long long)s.rowsFetched,
+			(long long)s.rowsAffected);
+		out.append("    ").append(s.fingerprint).append("\n");
+	}
+	return out;
+}
+
+std::string IBPP::QueryStatsJson(const std::vector<IBPP::QueryStats>& stats)
+{
+	std::string out = "[";
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		const IBPP::QueryStats& s = stats[i];
+		if (i > 0) out += ',';
+		out.append("{\"fingerprint\":\"");
+		for (size_t c = 0; c < s.fingerprint.length(); c++)
+		{
+			const unsigned char ch = (unsigned char)s.fingerprint[c];
+			if (ch == '"' || ch == '\\') out.append(1, '\\').append(1, (char)ch);
+			else if (ch < 0x20) appendText(out, "\\u%04x", ch);
+			else out += (char)ch;
+		}
+		appendText(out, "\",\"hash\":\"%016llx\",", (unsigned long long)s.hash);
+		appendJson(out, "prepare", s.prepare);
+		out += ',';
+		appendJson(out, "execute", s.execute);
+		out += ',';
+		appendJson(out, "fetch", s.fetch);
+		appendText(out, ",\"rowsFetched\":%lld,\"rowsAffected\":%lld}",
+			(long long)s.rowsFetched, (long long)s.rowsAffected);
+	}
+	out += ']';
+	return out;
+}
+
+std::string IBPP::QueryFingerprint(const std::string& sql)
+{
+	return QueryProfile::Fingerprint(sql);
+}
+
+//
+//	EOF
+//
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, Retry() implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <algorithm>
+#include <random>
+
+using namespace ibpp_internals;
+
+//	Counters of IBPP::RetryStatistics(), for all the Retry() calls
+static std::atomic<int64_t> retryRuns(0);
+static std::atomic<int64_t> retryConflicts(0);
+static std::atomic<int64_t> retryRetries(0);
+static std::atomic<int64_t> retryFailures(0);
+
+bool ibpp_internals::lockConflict(int enginecode)
+{
+	return enginecode == isc_lock_conflict || enginecode == isc_deadlock
+		|| enginecode == isc_update_conflict || enginecode == isc_lock_timeout;
+}
+
+int IBPP::Retry(IBPP::Transaction tr, const std::function<void()>& work,
+	const IBPP::RetryPolicy& policy)
+{
+	if (tr.intf() == 0)
+		throw LogicExceptionImpl("IBPP::Retry", _("No Transaction given."));
+	if (tr->Started())
+		throw LogicExceptionImpl("IBPP::Retry", _("The Transaction is already started."));
+	if (policy.maxAttempts < 1 || policy.firstDelayMs < 0 || policy.maxDelayMs < 0
+		|| policy.deadlineMs < 0 || policy.jitter < 0 || policy.jitter > 1)
+		throw LogicExceptionImpl("IBPP::Retry", _("Invalid retry policy."));
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point deadline =
+		Clock::now() + std::chrono::milliseconds(policy.deadlineMs);
+	static thread_local std::minstd_rand random(
+		(unsigned)std::hash<std::thread::id>()(std::this_thread::get_id()));
+	std::uniform_real_distribution<double> share(0.0, policy.jitter);
+
+	int delay = policy.firstDelayMs;
+	for (int run = 1; ; run++)
+	{
+		++retryRuns;
+		tr->Start();
+		try
+		{
+			work();
+			tr->Commit();
+			return run;
+		}
+		catch (IBPP::SQLException& e)
+		{
+			if (tr->Started())
+				try { tr->Rollback(); } catch (...) { }
+			if (! lockConflict(e.EngineCode())) throw;
+			++retryConflicts;
+
+			// The jitter keeps the transactions which conflicted from running
+			// again all at the same time
+			const int pause = delay - (int)(delay * share(random));
+			if (run >= policy.maxAttempts || (policy.deadlineMs > 0
+				&& Clock::now() + std::chrono::milliseconds(pause) >= deadline))
+			{
+				++retryFailures;
+				throw;
+			}
+			++retryRetries;
+			std::this_thread::sleep_for(std::chrono::milliseconds(pause));
+			delay = std::min(delay * 2, policy.maxDelayMs);
+		}
+		catch (...)
+		{
+			if (tr->Started())
+				try { tr->Rollback(); } catch (...) { }
+			throw;
+		}
+	}
+}
+
+void IBPP::RetryStatistics(int64_t* Runs, int64_t* Conflicts, int64_t* Retries,
+	int64_t* Failures)
+{
+	if (Runs != 0) *Runs = retryRuns;
+	if (Conflicts != 0) *Conflicts = retryConflicts;
+	if (Retries != 0) *Retries = retryRetries;
+	if (Failures != 0) *Failures = retryFailures;
+}
+
+//
+//	EOF
+//
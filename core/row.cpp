@@ -191,10 +191,14 @@ void RowImpl::Set(int param, const IBPP::Blob& blob)
 {
 	if (mDescrArea == 0)
 		throw LogicExceptionImpl("Row::Set[Blob]", _("The row is not initialized."));
-	if (mDatabase != 0 && blob->DatabasePtr() != mDatabase)
+
+	// Compares the attachments directly : going through DatabasePtr() and
+	// TransactionPtr() would cost an AddRef/Release pair on each of them.
+	BlobImpl* impl = (BlobImpl*)blob.intf();
+	if (mDatabase != 0 && impl->mDatabase != mDatabase)
 		throw LogicExceptionImpl("Row::Set[Blob]",
 			_("IBlob and Row attached to different databases"));
-	if (mTransaction != 0 && blob->TransactionPtr() != mTransaction)
+	if (mTransaction != 0 && impl->mTransaction != mTransaction)
 		throw LogicExceptionImpl("Row::Set[Blob]",
 			_("IBlob and Row attached to different transactions"));
 
@@ -206,10 +210,12 @@ void RowImpl::Set(int param, const IBPP::Array& array)
 {
 	if (mDescrArea == 0)
 		throw LogicExceptionImpl("Row::Set[Array]", _("The row is not initialized."));
-	if (mDatabase != 0 && array->DatabasePtr() != mDatabase)
+
+	ArrayImpl* impl = (ArrayImpl*)array.intf();
+	if (mDatabase != 0 && impl->mDatabase != mDatabase)
 		throw LogicExceptionImpl("Row::Set[Array]",
 			_("IArray and Row attached to different databases"));
-	if (mTransaction != 0 && array->TransactionPtr() != mTransaction)
+	if (mTransaction != 0 && impl->mTransaction != mTransaction)
 		throw LogicExceptionImpl("Row::Set[Array]",
 			_("IArray and Row attached to different transactions"));
 
@@ -598,36 +604,21 @@ int RowImpl::ColumnNum(const std::string& name)
 	// Local upper case copy of the column name
 	size_t len = name.length();
 	if (len > sizeof(var->sqlname)) len = sizeof(var->sqlname);
-	strncpy(Uname, name.c_str(), len);
+	for (size_t i = 0; i < len; i++) Uname[i] = char(toupper(name[i]));
 	Uname[len] = '\0';
-	char* p = Uname;
-	while (*p != '\0') { *p = char(toupper(*p)); ++p; }
-
-	// Loop through the columns of the descriptor
-	for (int i = 0; i < mDescrArea->sqld; i++)
-	{
-		var = &(mDescrArea->sqlvar[i]);
-		if (var->sqlname_length != (int16_t)len) continue;
-		if (strncmp(Uname, var->sqlname, len) == 0) return i+1;
-	}
 
-	// Failed finding the column name, let's retry using the aliases
-	char Ualias[sizeof(var->aliasname)+1];		// Max size of aliasname + '\0'
-
-	// Local upper case copy of the column name
-	len = name.length();
-	if (len > sizeof(var->aliasname)) len = sizeof(var->aliasname);
-	strncpy(Ualias, name.c_str(), len);
-	Ualias[len] = '\0';
-	p = Ualias;
-	while (*p != '\0') { *p = char(toupper(*p)); ++p; }
-
-	// Loop through the columns of the descriptor
-	for (int i = 0; i < mDescrArea->sqld; i++)
+	// Probe the index : a column name wins over a column alias
+	if (! mColumnIndex.empty())
 	{
-		var = &(mDescrArea->sqlvar[i]);
-		if (var->aliasname_length != (int16_t)len) continue;
-		if (strncmp(Ualias, var->aliasname, len) == 0) return i+1;
+		const size_t mask = mColumnIndex.size() - 1;
+		size_t i = ColumnHash(Uname, len) & mask;
+		int alias = 0;
+		for (int slot; (slot = mColumnIndex[i]) != 0; i = (i + 1) & mask)
+		{
+			if (slot > 0 && SameColumn(slot, Uname, len)) return slot;
+			if (slot < 0 && alias == 0 && SameColumn(slot, Uname, len)) alias = -slot;
+		}
+		if (alias != 0) return alias;
 	}
 
 	throw LogicExceptionImpl("Row::ColumnNum", _("Could not find matching column."));
@@ -636,6 +627,11 @@ int RowImpl::ColumnNum(const std::string& name)
 #endif
 }
 
+IBPP::ColumnHandle RowImpl::Column(const std::string& name)
+{
+	return IBPP::ColumnHandle(ColumnNum(name));
+}
+
 /*
 ColumnName, ColumnAlias, ColumnTable : all these 3 have a mistake.
 Ideally, the strings should be stored elsewhere (like _Numerics and so on) to
@@ -796,9 +792,18 @@ void RowImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
-		catch (...) { }
+	try
+	{
+		if (--mRefCount <= 0)
+		{
+			// Rows handed out by Statement::Fetch(Row&) go back to their pool
+			RowPool* pool = mPool;
+			mPool = 0;
+			if (pool == 0 || ! pool->Recycle(this)) delete this;
+			if (pool != 0) pool->Release();
+		}
+	}
+	catch (...) { }
 }
 
 //	(((((((( OBJECT INTERNAL METHODS ))))))))
@@ -1362,33 +1367,14 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 
 void RowImpl::Free()
 {
+	if (mBuffer != 0)
+	{
+		delete [] mBuffer;
+		mBuffer = 0;
+		mBufferSize = 0;
+	}
 	if (mDescrArea != 0)
 	{
-		for (int i = 0; i < mDescrArea->sqln; i++)
-		{
-			XSQLVAR* var = &(mDescrArea->sqlvar[i]);
-			if (var->sqldata != 0)
-			{
-				switch (var->sqltype & ~1)
-				{
-					case SQL_ARRAY :
-					case SQL_BLOB :		delete (ISC_QUAD*) var->sqldata; break;
-					case SQL_TIMESTAMP :delete (ISC_TIMESTAMP*) var->sqldata; break;
-					case SQL_TYPE_TIME :delete (ISC_TIME*) var->sqldata; break;
-					case SQL_TYPE_DATE :delete (ISC_DATE*) var->sqldata; break;
-					case SQL_TEXT :
-					case SQL_VARYING :	delete [] var->sqldata; break;
-					case SQL_SHORT :	delete (int16_t*) var->sqldata; break;
-					case SQL_LONG :		delete (int32_t*) var->sqldata; break;
-					case SQL_INT64 :	delete (int64_t*) var->sqldata; break;
-					case SQL_FLOAT : 	delete (float*) var->sqldata; break;
-					case SQL_DOUBLE :	delete (double*) var->sqldata; break;
-					default : throw LogicExceptionImpl("RowImpl::Free",
-								_("Found an unknown sqltype !"));
-				}
-			}
-			if (var->sqlind != 0) delete var->sqlind;
-		}
 		delete [] (char*)mDescrArea;
 		mDescrArea = 0;
 	}
@@ -1401,6 +1387,7 @@ void RowImpl::Free()
 	mBools.clear();
 	mStrings.clear();
 	mUpdated.clear();
+	mColumnIndex.clear();
 
 	mDialect = 0;
 	mDatabase = 0;
@@ -1409,11 +1396,23 @@ void RowImpl::Free()
 
 void RowImpl::Resize(int n)
 {
-	const int size = XSQLDA_LENGTH(n);
+	// A descriptor large enough is re-used (it keeps its allocated size)
+	if (mDescrArea == 0 || n > mDescrArea->sqln)
+	{
+		int dialect = mDialect;
+		DatabaseImpl* db = mDatabase;
+		TransactionImpl* tr = mTransaction;
+
+		Free();
+		mDescrArea = (XSQLDA*) new char[XSQLDA_LENGTH(n)];
 
-	Free();
-    mDescrArea = (XSQLDA*) new char[size];
+		mDialect = dialect;
+		mDatabase = db;
+		mTransaction = tr;
+	}
+	else n = mDescrArea->sqln;
 
+	const int size = XSQLDA_LENGTH(n);
 	memset(mDescrArea, 0, size);
 	mNumerics.resize(n);
 	mFloats.resize(n);
@@ -1439,46 +1438,144 @@ void RowImpl::Resize(int n)
 	mDescrArea->sqln = (int16_t)n;
 }
 
+//	The column names and aliases are indexed by an open addressing hash table,
+//	built once the row is described. Each slot holds a column number, positive
+//	for a name, negative for an alias, or 0 when free.
+
+size_t RowImpl::ColumnHash(const char* name, size_t len)
+{
+	size_t h = 2166136261u;		// FNV-1a
+	for (size_t i = 0; i < len; i++)
+		h = (h ^ (unsigned char)name[i]) * 16777619u;
+	return h;
+}
+
+bool RowImpl::SameColumn(int slot, const char* name, size_t len)
+{
+	XSQLVAR* var = &(mDescrArea->sqlvar[(slot > 0 ? slot : -slot) - 1]);
+	if (slot > 0)
+		return var->sqlname_length == (int16_t)len && strncmp(name, var->sqlname, len) == 0;
+	return var->aliasname_length == (int16_t)len && strncmp(name, var->aliasname, len) == 0;
+}
+
+void RowImpl::IndexColumns()
+{
+	const int n = mDescrArea->sqld;
+	size_t size = 4;
+	while (size < (size_t)(4 * n)) size <<= 1;	// At most half full
+	mColumnIndex.assign(size, 0);
+
+	const size_t mask = size - 1;
+	for (int k = 0; k < 2 * n; k++)
+	{
+		// All the names first, then all the aliases
+		XSQLVAR* var = &(mDescrArea->sqlvar[k % n]);
+		int slot = k < n ? k + 1 : -(k - n + 1);
+		const char* name = k < n ? var->sqlname : var->aliasname;
+		size_t len = k < n ? var->sqlname_length : var->aliasname_length;
+		if (len == 0) continue;
+
+		// The first column of a given name is the one found
+		size_t i = ColumnHash(name, len) & mask;
+		while (mColumnIndex[i] != 0)
+		{
+			if ((mColumnIndex[i] > 0) == (slot > 0)
+				&& SameColumn(mColumnIndex[i], name, len)) break;
+			i = (i + 1) & mask;
+		}
+		if (mColumnIndex[i] == 0) mColumnIndex[i] = (int16_t)slot;
+	}
+}
+
+//	Size in bytes and alignment of the sqldata of a column
+static int VarSize(const XSQLVAR* var, int& align)
+{
+	switch (var->sqltype & ~1)
+	{
+		case SQL_ARRAY :
+		case SQL_BLOB :		align = 8; return sizeof(ISC_QUAD);
+		case SQL_TIMESTAMP :align = 8; return sizeof(ISC_TIMESTAMP);
+		case SQL_TYPE_TIME :align = 4; return sizeof(ISC_TIME);
+		case SQL_TYPE_DATE :align = 4; return sizeof(ISC_DATE);
+		case SQL_TEXT :		align = 1; return var->sqllen+1;
+		case SQL_VARYING :	align = 2; return var->sqllen+3;
+		case SQL_SHORT :	align = 2; return sizeof(int16_t);
+		case SQL_LONG :		align = 4; return sizeof(int32_t);
+		case SQL_INT64 :	align = 8; return sizeof(int64_t);
+		case SQL_FLOAT : 	align = 4; return sizeof(float);
+		case SQL_DOUBLE :	align = 8; return sizeof(double);
+		default : throw LogicExceptionImpl("RowImpl::AllocVariables",
+					_("Found an unknown sqltype !"));
+	}
+}
+
+//	All the sqlind and sqldata of a row share one buffer : the indicators
+//	first, then the data of each column, aligned on its natural boundary.
+
 void RowImpl::AllocVariables()
 {
-	int i;
-	for (i = 0; i < mDescrArea->sqld; i++)
+	const int n = mDescrArea->sqld;
+	int i, align;
+
+	int size = n * (int)sizeof(short);
+	for (i = 0; i < n; i++)
+	{
+		int len = VarSize(&(mDescrArea->sqlvar[i]), align);
+		size = (size + align - 1) / align * align + len;
+	}
+
+	if (mBuffer != 0 && size != mBufferSize)
+	{
+		delete [] mBuffer;
+		mBuffer = 0;
+	}
+	if (mBuffer == 0) mBuffer = new char[size];
+	mBufferSize = size;
+
+	short* inds = (short*)mBuffer;
+	int offset = n * (int)sizeof(short);
+	for (i = 0; i < n; i++)
 	{
 		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+		int len = VarSize(var, align);
+		offset = (offset + align - 1) / align * align;
+		var->sqldata = mBuffer + offset;
+		offset += len;
 		switch (var->sqltype & ~1)
 		{
-			case SQL_ARRAY :
-			case SQL_BLOB :		var->sqldata = (char*) new ISC_QUAD;
-								memset(var->sqldata, 0, sizeof(ISC_QUAD));
-								break;
-			case SQL_TIMESTAMP :var->sqldata = (char*) new ISC_TIMESTAMP;
-								memset(var->sqldata, 0, sizeof(ISC_TIMESTAMP));
-								break;
-			case SQL_TYPE_TIME :var->sqldata = (char*) new ISC_TIME;
-								memset(var->sqldata, 0, sizeof(ISC_TIME));
-								break;
-			case SQL_TYPE_DATE :var->sqldata = (char*) new ISC_DATE;
-								memset(var->sqldata, 0, sizeof(ISC_DATE));
-								break;
-			case SQL_TEXT :		var->sqldata = new char[var->sqllen+1];
-								memset(var->sqldata, ' ', var->sqllen);
+			case SQL_TEXT :		memset(var->sqldata, ' ', var->sqllen);
 								var->sqldata[var->sqllen] = '\0';
 								break;
-			case SQL_VARYING :	var->sqldata = new char[var->sqllen+3];
-								memset(var->sqldata, 0, 2);
+			case SQL_VARYING :	memset(var->sqldata, 0, 2);
 								memset(var->sqldata+2, ' ', var->sqllen);
 								var->sqldata[var->sqllen+2] = '\0';
 								break;
-			case SQL_SHORT :	var->sqldata = (char*) new int16_t(0); break;
-			case SQL_LONG :		var->sqldata = (char*) new int32_t(0); break;
-			case SQL_INT64 :	var->sqldata = (char*) new int64_t(0); break;
-			case SQL_FLOAT : 	var->sqldata = (char*) new float(0.0); break;
-			case SQL_DOUBLE :	var->sqldata = (char*) new double(0.0); break;
-			default : throw LogicExceptionImpl("RowImpl::AllocVariables",
-						_("Found an unknown sqltype !"));
+			default :			memset(var->sqldata, 0, len);
 		}
-		if (var->sqltype & 1) var->sqlind = new short(-1);	// 0 indicator
+		inds[i] = -1;
+		if (var->sqltype & 1) var->sqlind = &inds[i];	// 0 indicator
 	}
+
+	IndexColumns();
+}
+
+bool RowImpl::CopyColumn(int varnum, const RowImpl& src, int srcnum)
+{
+	// Raw copy of a column value from another row, which column has the
+	// very same type and size. Returns false when it has not.
+	XSQLVAR* var = &(mDescrArea->sqlvar[varnum-1]);
+	const XSQLVAR* org = &(src.mDescrArea->sqlvar[srcnum-1]);
+	if ((var->sqltype & ~1) != (org->sqltype & ~1) || var->sqllen != org->sqllen
+		|| var->sqlscale != org->sqlscale) return false;
+
+	bool null = (org->sqltype & 1) != 0 && *org->sqlind == -1;
+	if (null && ! (var->sqltype & 1)) return false;
+
+	int align;
+	memcpy(var->sqldata, org->sqldata, VarSize(var, align));
+	if (var->sqltype & 1) *var->sqlind = short(null ? -1 : 0);
+	mUpdated[varnum-1] = true;
+	return true;
 }
 
 bool RowImpl::MissingValues()
@@ -1490,50 +1587,36 @@ bool RowImpl::MissingValues()
 
 RowImpl& RowImpl::operator=(const RowImpl& copied)
 {
-	Free();
+	if (this == &copied) return *this;
 
 	const int n = copied.mDescrArea->sqln;
 	const int size = XSQLDA_LENGTH(n);
 
+	// Storage of the same shape is simply overwritten, else re-allocated
+	if (mDescrArea == 0 || mDescrArea->sqln != n
+		|| (mBuffer == 0) != (copied.mBuffer == 0) || mBufferSize != copied.mBufferSize)
+	{
+		Free();
+		mDescrArea = (XSQLDA*) new char[size];
+		if (copied.mBuffer != 0) mBuffer = new char[copied.mBufferSize];
+		mBufferSize = copied.mBufferSize;
+	}
+
 	// Initial brute copy
-    mDescrArea = (XSQLDA*) new char[size];
 	memcpy(mDescrArea, copied.mDescrArea, size);
 
-	// Copy of the columns data
-	for (int i = 0; i < mDescrArea->sqld; i++)
+	// Copy of the columns data, then pointers rebased on our own buffer
+	if (mBuffer != 0)
 	{
-		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
-		XSQLVAR* org = &(copied.mDescrArea->sqlvar[i]);
-		switch (var->sqltype & ~1)
+		memcpy(mBuffer, copied.mBuffer, mBufferSize);
+		for (int i = 0; i < mDescrArea->sqld; i++)
 		{
-			case SQL_ARRAY :
-			case SQL_BLOB :		var->sqldata = (char*) new ISC_QUAD;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_QUAD));
-								break;
-			case SQL_TIMESTAMP :var->sqldata = (char*) new ISC_TIMESTAMP;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_TIMESTAMP));
-								break;
-			case SQL_TYPE_TIME :var->sqldata = (char*) new ISC_TIME;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_TIME));
-								break;
-			case SQL_TYPE_DATE :var->sqldata = (char*) new ISC_DATE;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_DATE));
-								break;
-			case SQL_TEXT :		var->sqldata = new char[var->sqllen+1];
-								memcpy(var->sqldata, org->sqldata, var->sqllen+1);
-								break;
-			case SQL_VARYING :	var->sqldata = new char[var->sqllen+3];
-								memcpy(var->sqldata, org->sqldata, var->sqllen+3);
-								break;
-			case SQL_SHORT :	var->sqldata = (char*) new int16_t(*(int16_t*)org->sqldata); break;
-			case SQL_LONG :		var->sqldata = (char*) new int32_t(*(int32_t*)org->sqldata); break;
-			case SQL_INT64 :	var->sqldata = (char*) new int64_t(*(int64_t*)org->sqldata); break;
-			case SQL_FLOAT : 	var->sqldata = (char*) new float(*(float*)org->sqldata); break;
-			case SQL_DOUBLE :	var->sqldata = (char*) new double(*(double*)org->sqldata); break;
-			default : throw LogicExceptionImpl("RowImpl::Ctor",
-						_("Found an unknown sqltype !"));
+			XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+			XSQLVAR* org = &(copied.mDescrArea->sqlvar[i]);
+			var->sqldata = mBuffer + (org->sqldata - copied.mBuffer);
+			if (var->sqltype & 1)
+				var->sqlind = (short*)(mBuffer + ((char*)org->sqlind - copied.mBuffer));
 		}
-		if (var->sqltype & 1) var->sqlind = new short(*org->sqlind);	// 0 indicator
 	}
 
 	// Pointers init, real data copy
@@ -1544,6 +1627,8 @@ RowImpl& RowImpl::operator=(const RowImpl& copied)
 	mInt16s = copied.mInt16s;
 	mBools = copied.mBools;
 	mStrings = copied.mStrings;
+	mUpdated = copied.mUpdated;
+	mColumnIndex = copied.mColumnIndex;
 
 	mDialect = copied.mDialect;
 	mDatabase = copied.mDatabase;
@@ -1553,19 +1638,18 @@ RowImpl& RowImpl::operator=(const RowImpl& copied)
 }
 
 RowImpl::RowImpl(const RowImpl& copied)
-	: IBPP::IRow(), mRefCount(0), mDescrArea(0)
+	: IBPP::IRow(), mRefCount(0), mDescrArea(0), mBuffer(0), mBufferSize(0),
+	mPool(0)
 {
 	// mRefCount and mDescrArea are set to 0 before using the assignment operator
 	*this = copied;		// The assignment operator does the real copy
 }
 
 RowImpl::RowImpl(int dialect, int n, DatabaseImpl* db, TransactionImpl* tr)
-	: mRefCount(0), mDescrArea(0)
+	: mRefCount(0), mDescrArea(0), mBuffer(0), mBufferSize(0),
+	mDialect(dialect), mDatabase(db), mTransaction(tr), mPool(0)
 {
 	Resize(n);
-	mDialect = dialect;
-	mDatabase = db;
-	mTransaction = tr;
 }
 
 RowImpl::~RowImpl()
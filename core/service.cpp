@@ -731,8 +731,7 @@ void ServiceImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
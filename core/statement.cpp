@@ -1,1305 +1,2248 @@
-///////////////////////////////////////////////////////////////////////////////
-//
-//	File    : $Id$
-//	Subject : IBPP, Service class implementation
-//
-///////////////////////////////////////////////////////////////////////////////
-//
-//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
-//
-//	The contents of this file are subject to the IBPP License (the "License");
-//	you may not use this file except in compliance with the License.  You may
-//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
-//	file which must have been distributed along with this file.
-//
-//	This software, distributed under the License, is distributed on an "AS IS"
-//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
-//	License for the specific language governing rights and limitations
-//	under the License.
-//
-///////////////////////////////////////////////////////////////////////////////
-//
-//	COMMENTS
-//	* Tabulations should be set every four characters when editing this file.
-//
-///////////////////////////////////////////////////////////////////////////////
-
-#ifdef _MSC_VER
-#pragma warning(disable: 4786 4996)
-#ifndef _DEBUG
-#pragma warning(disable: 4702)
-#endif
-#endif
-
-#include "_ibpp.h"
-
-#ifdef HAS_HDRSTOP
-#pragma hdrstop
-#endif
-
-using namespace ibpp_internals;
-
-//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
-
-void StatementImpl::Prepare(const std::string& sql)
-{
-	if (mDatabase == 0)
-		throw LogicExceptionImpl("Statement::Prepare", _("An IDatabase must be attached."));
-	if (mDatabase->GetHandle() == 0)
-		throw LogicExceptionImpl("Statement::Prepare", _("IDatabase must be connected."));
-	if (mTransaction == 0)
-		throw LogicExceptionImpl("Statement::Prepare", _("An ITransaction must be attached."));
-	if (mTransaction->GetHandle() == 0)
-		throw LogicExceptionImpl("Statement::Prepare", _("ITransaction must be started."));
-	if (sql.empty())
-		throw LogicExceptionImpl("Statement::Prepare", _("SQL statement can't be 0."));
-
-	// Saves the SQL sentence, only for reporting reasons in case of errors
-	mSql = sql;
-
-	IBS status;
-
-	// Free all resources currently attached to this Statement, then allocate
-	// a new statement descriptor.
-	Close();
-	(*gds.Call()->m_dsql_allocate_statement)(status.Self(), mDatabase->GetHandlePtr(), &mHandle);
-	if (status.Errors())
-		throw SQLExceptionImpl(status, "Statement::Prepare",
-			_("isc_dsql_allocate_statement failed"));
-
-	// Empirical estimate of parameters count and output columns count.
-	// This is by far not an exact estimation, which would require parsing the
-	// SQL statement. If the SQL statement contains '?' and ',' in string
-	// constants, this count will obviously be wrong, but it will be exagerated.
-	// It won't hurt. We just try to not have to re-allocate those descriptors later.
-	// So we prefer to get them a little bit larger than needed than the other way.
-	int16_t inEstimate = 0;
-	int16_t outEstimate = 1;
-	for (size_t i = 0; i < strlen(sql.c_str()); i++)
-	{
-		if (sql[i] == '?') ++inEstimate;
-		if (sql[i] == ',') ++outEstimate;
-	}
-
-	/*
-	DebugStream()<< "Prepare(\""<< sql<< "\")"<< fds;
-	DebugStream()<< _("Estimation: ")<< inEstimate<< _(" IN parameters and ")
-			<< outEstimate<< _(" OUT columns")<< fds;
-	*/
-
-	// Allocates output descriptor and prepares the statement
-	mOutRow = new RowImpl(mDatabase->Dialect(), outEstimate, mDatabase, mTransaction);
-	mOutRow->AddRef();
-
-	status.Reset();
-	(*gds.Call()->m_dsql_prepare)(status.Self(), mTransaction->GetHandlePtr(),
-		&mHandle, (short)sql.length(), const_cast<char*>(sql.c_str()),
-			short(mDatabase->Dialect()), mOutRow->Self());
-	if (status.Errors())
-	{
-		Close();
-		std::string context = "Statement::Prepare( ";
-		context.append(mSql).append(" )");
-		throw SQLExceptionImpl(status, context.c_str(),
-			_("isc_dsql_prepare failed"));
-	}
-
-	// Read what kind of statement was prepared
-	status.Reset();
-	char itemsReq[] = {isc_info_sql_stmt_type};
-	char itemsRes[8];
-	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
-		sizeof(itemsRes), itemsRes);
-	if (status.Errors())
-	{
-		Close();
-		throw SQLExceptionImpl(status, "Statement::Prepare",
-			_("isc_dsql_sql_info failed"));
-	}
-	if (itemsRes[0] == isc_info_sql_stmt_type)
-	{
-		switch (itemsRes[3])
-		{
-			case isc_info_sql_stmt_select :		mType = IBPP::stSelect; break;
-			case isc_info_sql_stmt_insert :		mType = IBPP::stInsert; break;
-			case isc_info_sql_stmt_update :		mType = IBPP::stUpdate; break;
-			case isc_info_sql_stmt_delete :		mType = IBPP::stDelete; break;
-			case isc_info_sql_stmt_ddl :		mType = IBPP::stDDL; break;
-			case isc_info_sql_stmt_exec_procedure : mType = IBPP::stExecProcedure; break;
-			case isc_info_sql_stmt_select_for_upd : mType = IBPP::stSelectUpdate; break;
-			case isc_info_sql_stmt_set_generator :	mType = IBPP::stSetGenerator; break;
-			case isc_info_sql_stmt_savepoint :	mType = IBPP::stSavePoint; break;
-			default : mType = IBPP::stUnsupported;
-		}
-	}
-	if (mType == IBPP::stUnknown || mType == IBPP::stUnsupported)
-	{
-		Close();
-		throw LogicExceptionImpl("Statement::Prepare",
-			_("Unknown or unsupported statement type"));
-	}
-
-	if (mOutRow->Columns() == 0)
-	{
-		// Get rid of the output descriptor, if it wasn't required (no output)
-		mOutRow->Release();
-		mOutRow = 0;
-		/*
-		DebugStream()<< _("Dropped output descriptor which was not required")<< fds;
-		*/
-	}
-	else if (mOutRow->Columns() > mOutRow->AllocatedSize())
-	{
-		// Resize the output descriptor (which is too small).
-		// The statement does not need to be prepared again, though the
-		// output columns must be described again.
-
-		/*
-		DebugStream()<< _("Resize output descriptor from ")
-			<< mOutRow->AllocatedSize()<< _(" to ")<< mOutRow->Columns()<< fds;
-		*/
-
-		mOutRow->Resize(mOutRow->Columns());
-		status.Reset();
-		(*gds.Call()->m_dsql_describe)(status.Self(), &mHandle, 1, mOutRow->Self());
-		if (status.Errors())
-		{
-			Close();
-			throw SQLExceptionImpl(status, "Statement::Prepare",
-				_("isc_dsql_describe failed"));
-		}
-	}
-
-	if (inEstimate > 0)
-	{
-		// Ready an input descriptor
-		mInRow = new RowImpl(mDatabase->Dialect(), inEstimate, mDatabase, mTransaction);
-		mInRow->AddRef();
-
-		status.Reset();
-		(*gds.Call()->m_dsql_describe_bind)(status.Self(), &mHandle, 1, mInRow->Self());
-		if (status.Errors())
-		{
-			Close();
-			throw SQLExceptionImpl(status, "Statement::Prepare",
-				_("isc_dsql_describe_bind failed"));
-		}
-
-		if (mInRow->Columns() == 0)
-		{
-			// Get rid of the input descriptor, if it wasn't required (no parameters)
-			mInRow->Release();
-			mInRow = 0;
-			/*
-			DebugStream()<< _("Dropped input descriptor which was not required")<< fds;
-			*/
-		}
-		else if (mInRow->Columns() > mInRow->AllocatedSize())
-		{
-			// Resize the input descriptor (which is too small).
-			// The statement does not need to be prepared again, though the
-			// parameters must be described again.
-
-			/*
-			DebugStream()<< _("Resize input descriptor from ")
-					<< mInRow->AllocatedSize()<< _(" to ")
-					<< mInRow->Columns()<< fds;
-			*/
-
-			mInRow->Resize(mInRow->Columns());
-			status.Reset();
-			(*gds.Call()->m_dsql_describe_bind)(status.Self(), &mHandle, 1, mInRow->Self());
-			if (status.Errors())
-			{
-				Close();
-				throw SQLExceptionImpl(status, "Statement::Prepare",
-					_("isc_dsql_describe_bind failed"));
-			}
-		}
-	}
-
-	// Allocates variables of the input descriptor
-	if (mInRow != 0)
-	{
-		// Turn on 'can be NULL' on each input parameter
-		for (int i = 0; i < mInRow->Columns(); i++)
-		{
-			XSQLVAR* var = &(mInRow->Self()->sqlvar[i]);
-			if (! (var->sqltype & 1)) var->sqltype += short(1);
-		}
-		mInRow->AllocVariables();
-	}
-
-	// Allocates variables of the output descriptor
-	if (mOutRow != 0) mOutRow->AllocVariables();
-}
-
-void StatementImpl::Plan(std::string& plan)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Plan", _("No statement has been prepared."));
-	if (mDatabase == 0)
-		throw LogicExceptionImpl("Statement::Plan", _("A Database must be attached."));
-	if (mDatabase->GetHandle() == 0)
-		throw LogicExceptionImpl("Statement::Plan", _("Database must be connected."));
-
-	IBS status;
-	RB result(4096);
-	char itemsReq[] = {isc_info_sql_get_plan};
-
-	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
-								   result.Size(), result.Self());
-	if (status.Errors()) throw SQLExceptionImpl(status,
-								"Statement::Plan", _("isc_dsql_sql_info failed."));
-
-	result.GetString(isc_info_sql_get_plan, plan);
-	if (plan[0] == '\n') plan.erase(0, 1);
-}
-
-void StatementImpl::Execute(const std::string& sql)
-{
-	if (! sql.empty()) Prepare(sql);
-
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Execute",
-			_("No statement has been prepared."));
-
-	// Check that a value has been set for each input parameter
-	if (mInRow != 0 && mInRow->MissingValues())
-		throw LogicExceptionImpl("Statement::Execute",
-			_("All parameters must be specified."));
-
-	CursorFree();	// Free a previous 'cursor' if any
-
-	IBS status;
-	if (mType == IBPP::stSelect)
-	{
-		// Could return a result set (none, single or multi rows)
-		(*gds.Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
-			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self());
-		if (status.Errors())
-		{
-			//Close();	Commented because Execute error should not free the statement
-			std::string context = "Statement::Execute( ";
-			context.append(mSql).append(" )");
-			throw SQLExceptionImpl(status, context.c_str(),
-				_("isc_dsql_execute failed"));
-		}
-		if (mOutRow != 0)
-		{
-			mResultSetAvailable = true;
-			mCursorOpened = true;
-		}
-	}
-	else
-	{
-		// Should return at most a single row
-		(*gds.Call()->m_dsql_execute2)(status.Self(), mTransaction->GetHandlePtr(),
-			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self(),
-			mOutRow == 0 ? 0 : mOutRow->Self());
-		if (status.Errors())
-		{
-			//Close();	Commented because Execute error should not free the statement
-			std::string context = "Statement::Execute( ";
-			context.append(mSql).append(" )");
-			throw SQLExceptionImpl(status, context.c_str(),
-				_("isc_dsql_execute2 failed"));
-		}
-	}
-}
-
-void StatementImpl::CursorExecute(const std::string& cursor, const std::string& sql)
-{
-	if (cursor.empty())
-		throw LogicExceptionImpl("Statement::CursorExecute", _("Cursor name can't be 0."));
-
-	if (! sql.empty()) Prepare(sql);
-
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::CursorExecute", _("No statement has been prepared."));
-	if (mType != IBPP::stSelectUpdate)
-		throw LogicExceptionImpl("Statement::CursorExecute", _("Statement must be a SELECT FOR UPDATE."));
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::CursorExecute", _("Statement would return no rows."));
-
-	// Check that a value has been set for each input parameter
-	if (mInRow != 0 && mInRow->MissingValues())
-		throw LogicExceptionImpl("Statement::CursorExecute",
-			_("All parameters must be specified."));
-
-	CursorFree();	// Free a previous 'cursor' if any
-
-	IBS status;
-	(*gds.Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
-		&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self());
-	if (status.Errors())
-	{
-		//Close();	Commented because Execute error should not free the statement
-		std::string context = "Statement::CursorExecute( ";
-		context.append(mSql).append(" )");
-		throw SQLExceptionImpl(status, context.c_str(),
-			_("isc_dsql_execute failed"));
-	}
-
-	status.Reset();
-	(*gds.Call()->m_dsql_set_cursor_name)(status.Self(), &mHandle, const_cast<char*>(cursor.c_str()), 0);
-	if (status.Errors())
-	{
-		//Close();	Commented because Execute error should not free the statement
-		throw SQLExceptionImpl(status, "Statement::CursorExecute",
-			_("isc_dsql_set_cursor_name failed"));
-	}
-
-	mResultSetAvailable = true;
-	mCursorOpened = true;
-}
-
-void StatementImpl::ExecuteImmediate(const std::string& sql)
-{
-	if (mDatabase == 0)
-		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("An IDatabase must be attached."));
-	if (mDatabase->GetHandle() == 0)
-		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("IDatabase must be connected."));
-	if (mTransaction == 0)
-		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("An ITransaction must be attached."));
-	if (mTransaction->GetHandle() == 0)
-		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("ITransaction must be started."));
-	if (sql.empty())
-		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("SQL statement can't be 0."));
-
-	IBS status;
-	Close();
-    (*gds.Call()->m_dsql_execute_immediate)(status.Self(), mDatabase->GetHandlePtr(),
-    	mTransaction->GetHandlePtr(), 0, const_cast<char*>(sql.c_str()),
-    		short(mDatabase->Dialect()), 0);
-    if (status.Errors())
-	{
-		std::string context = "Statement::ExecuteImmediate( ";
-		context.append(sql).append(" )");
-		throw SQLExceptionImpl(status, context.c_str(),
-			_("isc_dsql_execute_immediate failed"));
-	}
-}
-
-int StatementImpl::AffectedRows()
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::AffectedRows", _("No statement has been prepared."));
-	if (mDatabase == 0)
-		throw LogicExceptionImpl("Statement::AffectedRows", _("A Database must be attached."));
-	if (mDatabase->GetHandle() == 0)
-		throw LogicExceptionImpl("Statement::AffectedRows", _("Database must be connected."));
-
-	int count;
-	IBS status;
-	RB result;
-	char itemsReq[] = {isc_info_sql_records};
-
-	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
-		result.Size(), result.Self());
-	if (status.Errors()) throw SQLExceptionImpl(status,
-			"Statement::AffectedRows", _("isc_dsql_sql_info failed."));
-
-	if (mType == IBPP::stInsert)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_insert_count);
-	else if (mType == IBPP::stUpdate)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_update_count);
-	else if (mType == IBPP::stDelete)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_delete_count);
-	else if (mType == IBPP::stSelect)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_select_count);
-	else	count = 0;	// Returns zero count for unknown cases
-
-	return count;
-}
-
-bool StatementImpl::Fetch()
-{
-	if (! mResultSetAvailable)
-		throw LogicExceptionImpl("Statement::Fetch",
-			_("No statement has been executed or no result set available."));
-
-	IBS status;
-	int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
-	if (code == 100)	// This special code means "no more rows"
-	{
-		mResultSetAvailable = false;
-		// Oddly enough, fetching rows up to the last one seems to open
-		// an 'implicit' cursor that needs to be closed.
-		mCursorOpened = true;
-		CursorFree();	// Free the explicit or implicit cursor/result-set
-		return false;
-	}
-	if (status.Errors())
-	{
-		Close();
-		throw SQLExceptionImpl(status, "Statement::Fetch",
-			_("isc_dsql_fetch failed."));
-	}
-
-	return true;
-}
-
-bool StatementImpl::Fetch(IBPP::Row& row)
-{
-	if (! mResultSetAvailable)
-		throw LogicExceptionImpl("Statement::Fetch(row)",
-			_("No statement has been executed or no result set available."));
-
-	RowImpl* rowimpl = new RowImpl(*mOutRow);
-	row = rowimpl;
-
-	IBS status;
-	int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1,
-					rowimpl->Self());
-	if (code == 100)	// This special code means "no more rows"
-	{
-		mResultSetAvailable = false;
-		// Oddly enough, fetching rows up to the last one seems to open
-		// an 'implicit' cursor that needs to be closed.
-		mCursorOpened = true;
-		CursorFree();	// Free the explicit or implicit cursor/result-set
-		row.clear();
-		return false;
-	}
-	if (status.Errors())
-	{
-		Close();
-		row.clear();
-		throw SQLExceptionImpl(status, "Statement::Fetch(row)",
-			_("isc_dsql_fetch failed."));
-	}
-
-	return true;
-}
-
-void StatementImpl::Close()
-{
-	// Free all statement resources.
-	// Used before preparing a new statement or from destructor.
-
-	if (mInRow != 0) { mInRow->Release(); mInRow = 0; }
-	if (mOutRow != 0) { mOutRow->Release(); mOutRow = 0; }
-
-	mResultSetAvailable = false;
-	mCursorOpened = false;
-	mType = IBPP::stUnknown;
-
-	if (mHandle != 0)
-	{
-		IBS status;
-		(*gds.Call()->m_dsql_free_statement)(status.Self(), &mHandle, DSQL_drop);
-		mHandle = 0;
-		if (status.Errors())
-			throw SQLExceptionImpl(status, "Statement::Close(DSQL_drop)",
-				_("isc_dsql_free_statement failed."));
-	}
-}
-
-void StatementImpl::SetNull(int param)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::SetNull", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::SetNull", _("The statement does not take parameters."));
-
-	mInRow->SetNull(param);
-}
-
-void StatementImpl::Set(int param, bool value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[bool]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[bool]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, const char* cstring)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[char*]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[char*]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, cstring);
-}
-
-void StatementImpl::Set(int param, const void* bindata, int len)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[void*]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[void*]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, bindata, len);
-}
-
-void StatementImpl::Set(int param, const std::string& s)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[string]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[string]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, s);
-}
-
-void StatementImpl::Set(int param, int16_t value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[int16_t]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[int16_t]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, int32_t value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[int32_t]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[int32_t]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, int64_t value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[int64_t]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[int64_t]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, float value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[float]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[float]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, double value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[double]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[double]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, const IBPP::Timestamp& value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[Timestamp]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[Timestamp]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, const IBPP::Date& value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[Date]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[Date]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, const IBPP::Time& value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[Time]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[Time]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-
-void StatementImpl::Set(int param, const IBPP::Blob& blob)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[Blob]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[Blob]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, blob);
-}
-
-void StatementImpl::Set(int param, const IBPP::Array& array)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[Array]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[Array]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, array);
-}
-
-void StatementImpl::Set(int param, const IBPP::DBKey& key)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[DBKey]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[DBKey]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, key);
-}
-
-/*
-void StatementImpl::Set(int param, const IBPP::Value& value)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Set[Value]", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Set[Value]", _("The statement does not take parameters."));
-
-	mInRow->Set(param, value);
-}
-*/
-
-bool StatementImpl::IsNull(int column)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::IsNull", _("The row is not initialized."));
-
-	return mOutRow->IsNull(column);
-}
-
-bool StatementImpl::Get(int column, bool* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(column, *retvalue);
-}
-
-bool StatementImpl::Get(int column, bool& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, char* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, void* bindata, int& userlen)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, bindata, userlen);
-}
-
-bool StatementImpl::Get(int column, std::string& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, int16_t* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(column, *retvalue);
-}
-
-bool StatementImpl::Get(int column, int16_t& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, int32_t* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(column, *retvalue);
-}
-
-bool StatementImpl::Get(int column, int32_t& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, int64_t* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(column, *retvalue);
-}
-
-bool StatementImpl::Get(int column, int64_t& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, float* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(column, *retvalue);
-}
-
-bool StatementImpl::Get(int column, float& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, double* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(column, *retvalue);
-}
-
-bool StatementImpl::Get(int column, double& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, retvalue);
-}
-
-bool StatementImpl::Get(int column, IBPP::Timestamp& timestamp)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, timestamp);
-}
-
-bool StatementImpl::Get(int column, IBPP::Date& date)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, date);
-}
-
-bool StatementImpl::Get(int column, IBPP::Time& time)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, time);
-}
-
-bool StatementImpl::Get(int column, IBPP::Blob& blob)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, blob);
-}
-
-bool StatementImpl::Get(int column, IBPP::DBKey& key)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, key);
-}
-
-bool StatementImpl::Get(int column, IBPP::Array& array)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column, array);
-}
-
-/*
-const IBPP::Value StatementImpl::Get(int column)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(column);
-}
-*/
-
-bool StatementImpl::IsNull(const std::string& name)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::IsNull", _("The row is not initialized."));
-
-	return mOutRow->IsNull(name);
-}
-
-bool StatementImpl::Get(const std::string& name, bool* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(name, *retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, bool& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, char* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get[char*]", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, void* retvalue, int& count)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get[void*,int]", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue, count);
-}
-
-bool StatementImpl::Get(const std::string& name, std::string& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::GetString", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, int16_t* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(name, *retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, int16_t& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, int32_t* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(name, *retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, int32_t& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, int64_t* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(name, *retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, int64_t& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, float* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(name, *retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, float& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, double* retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-	if (retvalue == 0)
-		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
-
-	return mOutRow->Get(name, *retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, double& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, IBPP::Timestamp& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, IBPP::Date& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, IBPP::Time& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string&name, IBPP::Blob& retblob)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retblob);
-}
-
-bool StatementImpl::Get(const std::string& name, IBPP::DBKey& retvalue)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retvalue);
-}
-
-bool StatementImpl::Get(const std::string& name, IBPP::Array& retarray)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name, retarray);
-}
-
-/*
-const IBPP::Value StatementImpl::Get(const std::string& name)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
-
-	return mOutRow->Get(name);
-}
-*/
-
-int StatementImpl::Columns()
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
-
-	return mOutRow->Columns();
-}
-
-int StatementImpl::ColumnNum(const std::string& name)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::ColumnNum", _("The row is not initialized."));
-
-	return mOutRow->ColumnNum(name);
-}
-
-const char* StatementImpl::ColumnName(int varnum)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
-
-	return mOutRow->ColumnName(varnum);
-}
-
-const char* StatementImpl::ColumnAlias(int varnum)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
-
-	return mOutRow->ColumnAlias(varnum);
-}
-
-const char* StatementImpl::ColumnTable(int varnum)
-{
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
-
-	return mOutRow->ColumnTable(varnum);
-}
-
-IBPP::SDT StatementImpl::ColumnType(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ColumnType", _("No statement has been prepared."));
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::ColumnType", _("The statement does not return results."));
-
-    return mOutRow->ColumnType(varnum);
-}
-
-int StatementImpl::ColumnSubtype(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ColumnSubtype", _("No statement has been prepared."));
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::ColumnSubtype", _("The statement does not return results."));
-
-    return mOutRow->ColumnSubtype(varnum);
-}
-
-int StatementImpl::ColumnSize(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ColumnSize", _("No statement has been prepared."));
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::ColumnSize", _("The row is not initialized."));
-
-	return mOutRow->ColumnSize(varnum);
-}
-
-int StatementImpl::ColumnScale(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ColumnScale", _("No statement has been prepared."));
-	if (mOutRow == 0)
-		throw LogicExceptionImpl("Statement::ColumnScale", _("The row is not initialized."));
-
-	return mOutRow->ColumnScale(varnum);
-}
-
-int StatementImpl::Parameters()
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::Parameters", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::Parameters", _("The statement uses no parameters."));
-
-	return mInRow->Columns();
-}
-
-IBPP::SDT StatementImpl::ParameterType(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ParameterType", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::ParameterType", _("The statement uses no parameters."));
-
-    return mInRow->ColumnType(varnum);
-}
-
-int StatementImpl::ParameterSubtype(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ParameterSubtype", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::ParameterSubtype", _("The statement uses no parameters."));
-
-    return mInRow->ColumnSubtype(varnum);
-}
-
-int StatementImpl::ParameterSize(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ParameterSize", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::ParameterSize", _("The statement uses no parameters."));
-
-	return mInRow->ColumnSize(varnum);
-}
-
-int StatementImpl::ParameterScale(int varnum)
-{
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Statement::ParameterScale", _("No statement has been prepared."));
-	if (mInRow == 0)
-		throw LogicExceptionImpl("Statement::ParameterScale", _("The statement uses no parameters."));
-
-	return mInRow->ColumnScale(varnum);
-}
-
-IBPP::Database StatementImpl::DatabasePtr() const
-{
-	return mDatabase;
-}
-
-IBPP::Transaction StatementImpl::TransactionPtr() const
-{
-	return mTransaction;
-}
-
-IBPP::IStatement* StatementImpl::AddRef()
-{
-	ASSERTION(mRefCount >= 0);
-	++mRefCount;
-
-	return this;
-}
-
-void StatementImpl::Release()
-{
-	// Release cannot throw, except in DEBUG builds on assertion
-	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
-		catch (...) { }
-}
-
-//	(((((((( OBJECT INTERNAL METHODS ))))))))
-
-void StatementImpl::AttachDatabaseImpl(DatabaseImpl* database)
-{
-	if (database == 0)
-		throw LogicExceptionImpl("Statement::AttachDatabase",
-			_("Can't attach a 0 IDatabase object."));
-
-	if (mDatabase != 0) mDatabase->DetachStatementImpl(this);
-	mDatabase = database;
-	mDatabase->AttachStatementImpl(this);
-}
-
-void StatementImpl::DetachDatabaseImpl()
-{
-	if (mDatabase == 0) return;
-
-	Close();
-	mDatabase->DetachStatementImpl(this);
-	mDatabase = 0;
-}
-
-void StatementImpl::AttachTransactionImpl(TransactionImpl* transaction)
-{
-	if (transaction == 0)
-		throw LogicExceptionImpl("Statement::AttachTransaction",
-			_("Can't attach a 0 ITransaction object."));
-
-	if (mTransaction != 0) mTransaction->DetachStatementImpl(this);
-	mTransaction = transaction;
-	mTransaction->AttachStatementImpl(this);
-}
-
-void StatementImpl::DetachTransactionImpl()
-{
-	if (mTransaction == 0) return;
-
-	Close();
-	mTransaction->DetachStatementImpl(this);
-	mTransaction = 0;
-}
-
-void StatementImpl::CursorFree()
-{
-	if (mCursorOpened)
-	{
-		mCursorOpened = false;
-		if (mHandle != 0)
-		{
-			IBS status;
-			(*gds.Call()->m_dsql_free_statement)(status.Self(), &mHandle, DSQL_close);
-			if (status.Errors())
-				throw SQLExceptionImpl(status, "StatementImpl::CursorFree(DSQL_close)",
-					_("isc_dsql_free_statement failed."));
-		}
-	}
-}
-
-StatementImpl::StatementImpl(DatabaseImpl* database, TransactionImpl* transaction,
-	const std::string& sql)
-	: mRefCount(0), mHandle(0), mDatabase(0), mTransaction(0),
-	mInRow(0), mOutRow(0),
-	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown)
-{
-	AttachDatabaseImpl(database);
-	if (transaction != 0) AttachTransactionImpl(transaction);
-	if (! sql.empty()) Prepare(sql);
-}
-
-StatementImpl::~StatementImpl()
-{
-	try { Close(); }
-		catch (...) { }
-	try { if (mTransaction != 0) mTransaction->DetachStatementImpl(this); }
-		catch (...) { }
-	try { if (mDatabase != 0) mDatabase->DetachStatementImpl(this); }
-		catch (...) { }
-}
-
-//
-//	EOF
-//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, Service class implementation
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+using namespace ibpp_internals;
+
+//	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
+
+void StatementImpl::Prepare(const std::string& sql)
+{
+	THREADCHECK(mDatabase);
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::Prepare", _("An IDatabase must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::Prepare", _("IDatabase must be connected."));
+	if (mTransaction == 0)
+		throw LogicExceptionImpl("Statement::Prepare", _("An ITransaction must be attached."));
+	if (mTransaction->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::Prepare", _("ITransaction must be started."));
+	if (sql.empty())
+		throw LogicExceptionImpl("Statement::Prepare", _("SQL statement can't be 0."));
+
+	IBS status;
+
+	// Free all resources currently attached to this Statement, except the
+	// statement handle and descriptors which are re-used when possible.
+	Unprepare();
+
+	// Saves the SQL sentence, for reporting reasons in case of errors and
+	// as the key of this statement in the database cache
+	mSql = sql;
+	mProfile = 0;
+	QueryTimer timer(Profile(), &QueryProfile::mPrepare);
+
+	if (mHandle == 0)
+	{
+		// Take the same statement back from the database cache, or allocate
+		// a new statement descriptor.
+		if (mDatabase->UncacheStatement(sql, mHandle, mType, mInRow, mOutRow))
+		{
+			if (mInRow != 0)
+			{
+				mInRow->SetTransaction(mTransaction);
+				mInRow->ClearUpdated();
+			}
+			if (mOutRow != 0) mOutRow->SetTransaction(mTransaction);
+			BatchDescribe();
+			mCacheable = true;
+			PlanCheck();	// A policy set after the statement was cached
+			return;
+		}
+
+		(*gds.Call()->m_dsql_allocate_statement)(status.Self(), mDatabase->GetHandlePtr(), &mHandle);
+		if (status.Errors())
+			throw SQLExceptionImpl(status, "Statement::Prepare",
+				_("isc_dsql_allocate_statement failed"));
+	}
+
+	// Prepares the statement without any descriptor : the statement type and
+	// both descriptors then come back from a single isc_dsql_sql_info() call.
+	status.Reset();
+	(*gds.Call()->m_dsql_prepare)(status.Self(), mTransaction->GetHandlePtr(),
+		&mHandle, (short)sql.length(), const_cast<char*>(sql.c_str()),
+			short(mDatabase->Dialect()), 0);
+	if (status.Errors())
+	{
+		Close();
+		std::string context = "Statement::Prepare( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(),
+			_("isc_dsql_prepare failed"));
+	}
+
+	status.Reset();
+	char itemsReq[] = {isc_info_sql_stmt_type,
+		isc_info_sql_select, isc_info_sql_describe_vars,
+			isc_info_sql_sqlda_seq, isc_info_sql_type, isc_info_sql_sub_type,
+			isc_info_sql_scale, isc_info_sql_length, isc_info_sql_field,
+			isc_info_sql_relation, isc_info_sql_owner, isc_info_sql_alias,
+			isc_info_sql_describe_end,
+		isc_info_sql_bind, isc_info_sql_describe_vars,
+			isc_info_sql_sqlda_seq, isc_info_sql_type, isc_info_sql_sub_type,
+			isc_info_sql_scale, isc_info_sql_length, isc_info_sql_describe_end};
+	RB result(32000);
+	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, sizeof(itemsReq), itemsReq,
+		result.Size(), result.Self());
+	if (status.Errors())
+	{
+		Close();
+		throw SQLExceptionImpl(status, "Statement::Prepare",
+			_("isc_dsql_sql_info failed"));
+	}
+
+	// Read what kind of statement was prepared
+	char* p = result.Self();
+	if (*p == isc_info_sql_stmt_type)
+	{
+		int len = (*gds.Call()->m_vax_integer)(p+1, 2);
+		switch ((*gds.Call()->m_vax_integer)(p+3, (short)len))
+		{
+			case isc_info_sql_stmt_select :		mType = IBPP::stSelect; break;
+			case isc_info_sql_stmt_insert :		mType = IBPP::stInsert; break;
+			case isc_info_sql_stmt_update :		mType = IBPP::stUpdate; break;
+			case isc_info_sql_stmt_delete :		mType = IBPP::stDelete; break;
+			case isc_info_sql_stmt_ddl :		mType = IBPP::stDDL; break;
+			case isc_info_sql_stmt_exec_procedure : mType = IBPP::stExecProcedure; break;
+			case isc_info_sql_stmt_select_for_upd : mType = IBPP::stSelectUpdate; break;
+			case isc_info_sql_stmt_set_generator :	mType = IBPP::stSetGenerator; break;
+			case isc_info_sql_stmt_savepoint :	mType = IBPP::stSavePoint; break;
+			default : mType = IBPP::stUnsupported;
+		}
+		p += 3 + len;
+	}
+	if (mType == IBPP::stUnknown || mType == IBPP::stUnsupported)
+	{
+		Close();
+		throw LogicExceptionImpl("Statement::Prepare",
+			_("Unknown or unsupported statement type"));
+	}
+
+	// Output columns and input parameters, in descriptors of the exact size.
+	// Should the answer have been truncated (very wide statements), use the
+	// describe calls instead.
+	if (! DescribeFromInfo(p, isc_info_sql_select, mOutRow)
+		|| ! DescribeFromInfo(p, isc_info_sql_bind, mInRow))
+	{
+		Describe(mOutRow, false);
+		Describe(mInRow, true);
+	}
+
+	// Allocates variables of the input descriptor
+	if (mInRow != 0)
+	{
+		// Turn on 'can be NULL' on each input parameter
+		for (int i = 0; i < mInRow->Columns(); i++)
+		{
+			XSQLVAR* var = &(mInRow->Self()->sqlvar[i]);
+			if (! (var->sqltype & 1)) var->sqltype += short(1);
+		}
+		mInRow->AllocVariables();
+	}
+
+	// Allocates variables of the output descriptor
+	if (mOutRow != 0) mOutRow->AllocVariables();
+	BatchDescribe();
+
+	// The statement may now be recycled through the database cache, unless
+	// it is a SELECT FOR UPDATE which cursor name would stick to the handle
+	mCacheable = mType != IBPP::stSelectUpdate;
+
+	PlanCheck();	// See IBPP::SetPlanPolicy()
+}
+
+void StatementImpl::Plan(std::string& plan)
+{
+	THREADCHECK(mDatabase);
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Plan", _("No statement has been prepared."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::Plan", _("A Database must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::Plan", _("Database must be connected."));
+
+	IBS status;
+	RB result(4096);
+	char itemsReq[] = {isc_info_sql_get_plan};
+
+	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
+								   result.Size(), result.Self());
+	if (status.Errors()) throw SQLExceptionImpl(status,
+								"Statement::Plan", _("isc_dsql_sql_info failed."));
+
+	result.GetString(isc_info_sql_get_plan, plan);
+	if (plan[0] == '\n') plan.erase(0, 1);
+}
+
+void StatementImpl::Plan(std::vector<IBPP::PlanNode>& plans)
+{
+	std::string text;
+	Plan(text);
+	IBPP::ParsePlan(text, plans);
+}
+
+void StatementImpl::Execute(const std::string& sql)
+{
+	if (! sql.empty()) Prepare(sql);
+
+	IBS status;
+	const char* failed = ExecuteCall("Statement::Execute", status);
+	if (failed != 0)
+	{
+		//Close();	Commented because Execute error should not free the statement
+		std::string context = "Statement::Execute( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(), failed);
+	}
+}
+
+IBPP::Status StatementImpl::TryExecute()
+{
+	IBS status;
+	if (ExecuteCall("Statement::TryExecute", status) != 0)
+		return IBPP::Status(status.Self(), "Statement::TryExecute");
+	return IBPP::Status();
+}
+
+bool StatementImpl::ExecuteSingleton(const std::string& sql)
+{
+	if (! sql.empty()) Prepare(sql);
+
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExecuteSingleton",
+			_("No statement has been prepared."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ExecuteSingleton",
+			_("Statement would return no rows."));
+
+	// The row comes back with the execute reply itself, without any cursor.
+	// A select returning more than one row is an error of the server.
+	mResultSetAvailable = false;
+	IBS status;
+	bool found;
+	const char* failed = ExecuteCall("Statement::ExecuteSingleton", status, &found);
+	if (failed != 0)
+	{
+		std::string context = "Statement::ExecuteSingleton( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(), failed);
+	}
+
+	QueryProfile* profile = Profile();
+	if (found && profile != 0) ++profile->mRowsFetched;
+	return found;
+}
+
+void StatementImpl::CursorExecute(const std::string& cursor, const std::string& sql)
+{
+	THREADCHECK(mDatabase);
+	if (cursor.empty())
+		throw LogicExceptionImpl("Statement::CursorExecute", _("Cursor name can't be 0."));
+
+	if (! sql.empty()) Prepare(sql);
+
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::CursorExecute", _("No statement has been prepared."));
+	if (mType != IBPP::stSelectUpdate)
+		throw LogicExceptionImpl("Statement::CursorExecute", _("Statement must be a SELECT FOR UPDATE."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::CursorExecute", _("Statement would return no rows."));
+
+	// Check that a value has been set for each input parameter
+	if (mInRow != 0 && mInRow->MissingValues())
+		throw LogicExceptionImpl("Statement::CursorExecute",
+			_("All parameters must be specified."));
+
+	CursorFree();	// Free a previous 'cursor' if any
+
+	IBS status;
+	mPerf.Begin(&mDatabase, 1);
+	QueryTimer timer(Profile(), &QueryProfile::mExecute);
+	(*gds.Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
+		&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self());
+	timer.Stop();
+	if (status.Errors())
+	{
+		mPerf.End(&mDatabase, 1);
+		//Close();	Commented because Execute error should not free the statement
+		std::string context = "Statement::CursorExecute( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(),
+			_("isc_dsql_execute failed"));
+	}
+
+	status.Reset();
+	(*gds.Call()->m_dsql_set_cursor_name)(status.Self(), &mHandle, const_cast<char*>(cursor.c_str()), 0);
+	if (status.Errors())
+	{
+		//Close();	Commented because Execute error should not free the statement
+		throw SQLExceptionImpl(status, "Statement::CursorExecute",
+			_("isc_dsql_set_cursor_name failed"));
+	}
+
+	mResultSetAvailable = true;
+	mCursorOpened = true;
+}
+
+void StatementImpl::ExecuteImmediate(const std::string& sql)
+{
+	THREADCHECK(mDatabase);
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("An IDatabase must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("IDatabase must be connected."));
+	if (mTransaction == 0)
+		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("An ITransaction must be attached."));
+	if (mTransaction->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("ITransaction must be started."));
+	if (sql.empty())
+		throw LogicExceptionImpl("Statement::ExecuteImmediate", _("SQL statement can't be 0."));
+
+	IBS status;
+	Close();
+    (*gds.Call()->m_dsql_execute_immediate)(status.Self(), mDatabase->GetHandlePtr(),
+    	mTransaction->GetHandlePtr(), 0, const_cast<char*>(sql.c_str()),
+    		short(mDatabase->Dialect()), 0);
+    if (status.Errors())
+	{
+		std::string context = "Statement::ExecuteImmediate( ";
+		context.append(sql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(),
+			_("isc_dsql_execute_immediate failed"));
+	}
+}
+
+int StatementImpl::AffectedRows()
+{
+	THREADCHECK(mDatabase);
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::AffectedRows", _("No statement has been prepared."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::AffectedRows", _("A Database must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::AffectedRows", _("Database must be connected."));
+
+	int count;
+	IBS status;
+	RB result;
+	char itemsReq[] = {isc_info_sql_records};
+
+	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
+		result.Size(), result.Self());
+	if (status.Errors()) throw SQLExceptionImpl(status,
+			"Statement::AffectedRows", _("isc_dsql_sql_info failed."));
+
+	if (mType == IBPP::stInsert)
+			count = result.GetValue(isc_info_sql_records, isc_info_req_insert_count);
+	else if (mType == IBPP::stUpdate)
+			count = result.GetValue(isc_info_sql_records, isc_info_req_update_count);
+	else if (mType == IBPP::stDelete)
+			count = result.GetValue(isc_info_sql_records, isc_info_req_delete_count);
+	else if (mType == IBPP::stSelect)
+			count = result.GetValue(isc_info_sql_records, isc_info_req_select_count);
+	else	count = 0;	// Returns zero count for unknown cases
+
+	return count;
+}
+
+bool StatementImpl::Fetch()
+{
+	THREADCHECK(mDatabase);
+	if (! mResultSetAvailable)
+		throw LogicExceptionImpl("Statement::Fetch",
+			_("No statement has been executed or no result set available."));
+
+	QueryProfile* profile = Profile();
+	QueryTimer timer(profile, &QueryProfile::mFetch);
+	if (mPrefetch != 0)
+	{
+		RowImpl* row = PrefetchNext("Statement::Fetch");
+		if (row == 0) return false;
+		IBPP::Row fetched = row;	// Back to the pool once copied
+		*mOutRow = *row;
+		if (profile != 0) ++profile->mRowsFetched;
+		return true;
+	}
+
+	IBS status;
+	int code = FetchCall(status);
+	if (status.Errors())
+		throw SQLExceptionImpl(status, "Statement::Fetch",
+			_("isc_dsql_fetch failed."));
+
+	if (code == 100) return false;
+	if (profile != 0) ++profile->mRowsFetched;
+	return true;
+}
+
+IBPP::Status StatementImpl::TryFetch(bool& fetched)
+{
+	THREADCHECK(mDatabase);
+	fetched = false;
+	if (! mResultSetAvailable)
+		throw LogicExceptionImpl("Statement::TryFetch",
+			_("No statement has been executed or no result set available."));
+
+	QueryProfile* profile = Profile();
+	QueryTimer timer(profile, &QueryProfile::mFetch);
+	IBS status;
+	if (mPrefetch != 0)
+	{
+		// A failed fetch of the prefetching thread is returned as well
+		RowImpl* row = PrefetchNext("Statement::TryFetch", &status);
+		if (status.Errors())
+			return IBPP::Status(status.Self(), "Statement::TryFetch");
+		if (row == 0) return IBPP::Status();
+		IBPP::Row next = row;	// Back to the pool once copied
+		*mOutRow = *row;
+		fetched = true;
+		if (profile != 0) ++profile->mRowsFetched;
+		return IBPP::Status();
+	}
+
+	int code = FetchCall(status);
+	if (status.Errors())
+		return IBPP::Status(status.Self(), "Statement::TryFetch");
+
+	fetched = code != 100;
+	if (fetched && profile != 0) ++profile->mRowsFetched;
+	return IBPP::Status();
+}
+
+bool StatementImpl::Fetch(IBPP::Row& row)
+{
+	THREADCHECK(mDatabase);
+	if (! mResultSetAvailable)
+		throw LogicExceptionImpl("Statement::Fetch(row)",
+			_("No statement has been executed or no result set available."));
+
+	// Releasing the previous row first lets it be recycled right away when
+	// nobody else holds it : a 'while (Fetch(row))' loop re-uses one row.
+	row.clear();
+	QueryProfile* profile = Profile();
+	QueryTimer timer(profile, &QueryProfile::mFetch);
+	if (mPrefetch != 0)
+	{
+		RowImpl* rowimpl = PrefetchNext("Statement::Fetch(row)");
+		if (rowimpl == 0) return false;
+		row = rowimpl;
+		if (profile != 0) ++profile->mRowsFetched;
+		return true;
+	}
+	if (mRowPool == 0) mRowPool = new RowPool;
+	RowImpl* rowimpl = mRowPool->Take(*mOutRow);
+	row = rowimpl;
+
+	IBS status;
+	int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1,
+					rowimpl->Self());
+	if (code == 100)	// This special code means "no more rows"
+	{
+		mResultSetAvailable = false;
+		// Oddly enough, fetching rows up to the last one seems to open
+		// an 'implicit' cursor that needs to be closed.
+		mCursorOpened = true;
+		CursorFree();	// Free the explicit or implicit cursor/result-set
+		row.clear();
+		return false;
+	}
+	if (status.Errors())
+	{
+		mCacheable = false;		// Don't recycle a statement in error
+		Close();
+		row.clear();
+		throw SQLExceptionImpl(status, "Statement::Fetch(row)",
+			_("isc_dsql_fetch failed."));
+	}
+
+	if (profile != 0) ++profile->mRowsFetched;
+	return true;
+}
+
+int StatementImpl::FetchBatch(IBPP::ColumnBatch& batch, int rows)
+{
+	THREADCHECK(mDatabase);
+	if (mPrefetch != 0)
+		throw LogicExceptionImpl("Statement::FetchBatch",
+			_("Can't be used while the result set is prefetched."));
+
+	// A short batch already hit the end of the result set, so the next call
+	// simply returns an empty batch (this gives 'while (FetchBatch() > 0)').
+	if (! mResultSetAvailable && mBatchEnded)
+	{
+		BatchSetup(batch);
+		return 0;
+	}
+	if (! mResultSetAvailable)
+		throw LogicExceptionImpl("Statement::FetchBatch",
+			_("No statement has been executed or no result set available."));
+	if (rows <= 0)
+		throw LogicExceptionImpl("Statement::FetchBatch",
+			_("The count of rows to fetch must be positive."));
+
+	BatchSetup(batch);
+	QueryProfile* profile = Profile();
+	QueryTimer timer(profile, &QueryProfile::mFetch);
+
+	// Fixed size columns are written in place, so they are sized for the
+	// largest batch up-front. The storage is kept from one batch to the next.
+	const int bytes = (rows + 7) / 8;
+	const int columns = (int)mBatchCopies.size();
+	int col;
+	for (col = 0; col < columns; col++)
+	{
+		IBPP::ColumnBatch::Column& c = batch.mColumns[col];
+		c.nulls.assign(bytes, 0);
+		switch (mBatchCopies[col])
+		{
+			case bkInt16 :		c.values.resize(rows * sizeof(int16_t)); break;
+			case bkInt32 :
+			case bkDate :
+			case bkTime :		c.values.resize(rows * sizeof(int32_t)); break;
+			case bkInt64 :		c.values.resize(rows * sizeof(int64_t)); break;
+			case bkFloat :		c.values.resize(rows * sizeof(float)); break;
+			case bkDouble :		c.values.resize(rows * sizeof(double)); break;
+			case bkTimestamp :	c.values.resize(rows * 2 * sizeof(int32_t)); break;
+			case bkText :
+			case bkVarying :	c.values.clear();
+								c.offsets.resize(rows + 1);
+								c.offsets[0] = 0;
+								break;
+			case bkNone :		break;	// Refused by BatchSetup()
+		}
+	}
+
+	IBS status;
+	int fetched = 0;
+	while (fetched < rows)
+	{
+		int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
+		if (code == 100)	// This special code means "no more rows"
+		{
+			mResultSetAvailable = false;
+			// Oddly enough, fetching rows up to the last one seems to open
+			// an 'implicit' cursor that needs to be closed.
+			mCursorOpened = true;
+			CursorFree();	// Free the explicit or implicit cursor/result-set
+			mBatchEnded = true;
+			break;
+		}
+		if (status.Errors())
+		{
+			mCacheable = false;		// Don't recycle a statement in error
+			Close();
+			throw SQLExceptionImpl(status, "Statement::FetchBatch",
+				_("isc_dsql_fetch failed."));
+		}
+
+		for (col = 0; col < columns; col++)
+		{
+			IBPP::ColumnBatch::Column& c = batch.mColumns[col];
+			XSQLVAR* var = &(mOutRow->Self()->sqlvar[col]);
+			bool null = (var->sqltype & 1) != 0 && *var->sqlind == -1;
+			if (null) c.nulls[fetched / 8] |= (unsigned char)(1 << (fetched % 8));
+
+			char* p = c.values.empty() ? 0 : &c.values[0];
+			switch (mBatchCopies[col])
+			{
+				case bkInt16 :
+					((int16_t*)p)[fetched] = null ? 0 : *(int16_t*)var->sqldata;
+					break;
+				case bkInt32 :
+					((int32_t*)p)[fetched] = null ? 0 : *(int32_t*)var->sqldata;
+					break;
+				case bkInt64 :
+					((int64_t*)p)[fetched] = null ? 0 : *(int64_t*)var->sqldata;
+					break;
+				case bkFloat :
+					((float*)p)[fetched] = null ? 0.0f : *(float*)var->sqldata;
+					break;
+				case bkDouble :
+					((double*)p)[fetched] = null ? 0.0 : *(double*)var->sqldata;
+					break;
+				case bkDate :	// Same shift as in encodeDate() / decodeDate()
+					((int32_t*)p)[fetched] = null ? 0 :
+						(int32_t)*(ISC_DATE*)var->sqldata - 15019;
+					break;
+				case bkTime :
+					((int32_t*)p)[fetched] = null ? 0 :
+						(int32_t)*(ISC_TIME*)var->sqldata;
+					break;
+				case bkTimestamp :
+					((int32_t*)p)[2*fetched] = null ? 0 :
+						(int32_t)((ISC_TIMESTAMP*)var->sqldata)->timestamp_date - 15019;
+					((int32_t*)p)[2*fetched+1] = null ? 0 :
+						(int32_t)((ISC_TIMESTAMP*)var->sqldata)->timestamp_time;
+					break;
+				case bkText :
+					if (! null) c.values.insert(c.values.end(),
+						var->sqldata, var->sqldata + var->sqllen);
+					c.offsets[fetched+1] = (int32_t)c.values.size();
+					break;
+				case bkVarying :
+					if (! null) c.values.insert(c.values.end(), var->sqldata + 2,
+						var->sqldata + 2 + *(int16_t*)var->sqldata);
+					c.offsets[fetched+1] = (int32_t)c.values.size();
+					break;
+				case bkNone :
+					break;
+			}
+		}
+		++fetched;
+	}
+
+	// Trim the columns to the count of rows actually read
+	for (col = 0; col < columns; col++)
+	{
+		IBPP::ColumnBatch::Column& c = batch.mColumns[col];
+		c.nulls.resize((fetched + 7) / 8);
+		switch (mBatchCopies[col])
+		{
+			case bkInt16 :		c.values.resize(fetched * sizeof(int16_t)); break;
+			case bkInt32 :
+			case bkDate :
+			case bkTime :		c.values.resize(fetched * sizeof(int32_t)); break;
+			case bkInt64 :		c.values.resize(fetched * sizeof(int64_t)); break;
+			case bkFloat :		c.values.resize(fetched * sizeof(float)); break;
+			case bkDouble :		c.values.resize(fetched * sizeof(double)); break;
+			case bkTimestamp :	c.values.resize(fetched * 2 * sizeof(int32_t)); break;
+			case bkText :
+			case bkVarying :	c.offsets.resize(fetched + 1); break;
+			case bkNone :		break;
+		}
+	}
+	batch.mRows = fetched;
+	if (profile != 0) profile->mRowsFetched += fetched;
+
+	return fetched;
+}
+
+void StatementImpl::Prefetch(int RingSize, IBPP::PFP policy)
+{
+	THREADCHECK(mDatabase);
+	if (! mResultSetAvailable)
+		throw LogicExceptionImpl("Statement::Prefetch",
+			_("No statement has been executed or no result set available."));
+	if (mPrefetch != 0)
+		throw LogicExceptionImpl("Statement::Prefetch",
+			_("The result set is already prefetched."));
+	if (RingSize <= 0)
+		throw LogicExceptionImpl("Statement::Prefetch",
+			_("The ring size must be positive."));
+
+	if (mRowPool == 0) mRowPool = new RowPool;
+	mPrefetchStats[0] = mPrefetchStats[1] = mPrefetchStats[2] = 0;
+	mPrefetch = new Prefetcher(&mHandle, *mOutRow, mRowPool, RingSize, policy);
+}
+
+void StatementImpl::PrefetchStatistics(int* Rows, int* Stalls, int* Waits)
+{
+	if (mPrefetch != 0)
+		mPrefetch->Statistics(&mPrefetchStats[0], &mPrefetchStats[1], &mPrefetchStats[2]);
+
+	if (Rows != 0) *Rows = mPrefetchStats[0];
+	if (Stalls != 0) *Stalls = mPrefetchStats[1];
+	if (Waits != 0) *Waits = mPrefetchStats[2];
+}
+
+void StatementImpl::AddBatch()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::AddBatch", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::AddBatch", _("The statement does not take parameters."));
+	if (mInRow->MissingValues())
+		throw LogicExceptionImpl("Statement::AddBatch", _("All parameters must be specified."));
+
+	// Queue a copy of the current parameters
+	RowImpl* row = new RowImpl(*mInRow);
+	row->AddRef();
+	mBatch.push_back(row);
+}
+
+void StatementImpl::ClearBatch()
+{
+	for (size_t i = 0; i < mBatch.size(); i++)
+		mBatch[i]->Release();
+	mBatch.clear();
+}
+
+void StatementImpl::ExecuteBatch(std::vector<int>& affected,
+	std::vector<IBPP::BatchError>& errors, int chunk)
+{
+	THREADCHECK(mDatabase);
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExecuteBatch", _("No statement has been prepared."));
+	if (mType == IBPP::stSelect || mType == IBPP::stSelectUpdate)
+		throw LogicExceptionImpl("Statement::ExecuteBatch", _("A query can't be run as a batch."));
+	if (chunk < 0)
+		throw LogicExceptionImpl("Statement::ExecuteBatch", _("Invalid chunk size %d."), chunk);
+
+	affected.assign(mBatch.size(), -1);
+	errors.clear();
+
+	// Each chunk of rows runs as one EXECUTE BLOCK, if this statement can.
+	// A failed block did nothing (it is atomic) : it is split to isolate the
+	// rows in error and apply the others, see BatchRunSplit().
+	chunk = BatchChunk(chunk);
+	int first = 0;
+	while (first < (int)mBatch.size())
+	{
+		int count = (int)mBatch.size() - first;
+		if (chunk == 0) BatchRunRows(first, count, affected, errors);
+		else
+		{
+			if (count > chunk) count = chunk;
+			BatchRunSplit(first, count, affected, errors);
+		}
+		first += count;
+	}
+
+	ClearBatch();
+}
+
+void StatementImpl::Close()
+{
+	THREADCHECK(mDatabase);
+	// Free all statement resources.
+	// Used before preparing a new statement or from destructor.
+
+	PrefetchStop();
+
+	if (mCacheable && mHandle != 0 && mDatabase != 0)
+	{
+		// A statement still prepared goes to the database cache (if enabled)
+		// once its cursor is closed. It is simply dropped when that fails.
+		mCacheable = false;
+		try
+		{
+			CursorFree();
+			if (mDatabase->CacheStatement(mSql, mHandle, mType, mInRow, mOutRow))
+			{
+				mHandle = 0;
+				mInRow = 0;
+				mOutRow = 0;
+			}
+		}
+		catch (...) { }
+	}
+	mCacheable = false;
+
+	BatchFree();
+	if (mInRow != 0) { mInRow->Release(); mInRow = 0; }
+	if (mOutRow != 0) { mOutRow->Release(); mOutRow = 0; }
+	if (mRowPool != 0) { mRowPool->Drain(); mRowPool->Release(); mRowPool = 0; }
+
+	mResultSetAvailable = false;
+	mCursorOpened = false;
+	mType = IBPP::stUnknown;
+	mBatchCopies.clear();
+	mBatchEnded = false;
+
+	if (mHandle != 0)
+	{
+		IBS status;
+		(*gds.Call()->m_dsql_free_statement)(status.Self(), &mHandle, DSQL_drop);
+		mHandle = 0;
+		if (status.Errors())
+			throw SQLExceptionImpl(status, "Statement::Close(DSQL_drop)",
+				_("isc_dsql_free_statement failed."));
+	}
+}
+
+void StatementImpl::SetNull(int param)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::SetNull", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::SetNull", _("The statement does not take parameters."));
+
+	mInRow->SetNull(param);
+}
+
+void StatementImpl::Set(int param, bool value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[bool]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[bool]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const char* cstring)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[char*]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[char*]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, cstring);
+}
+
+void StatementImpl::Set(int param, const void* bindata, int len)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[void*]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[void*]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, bindata, len);
+}
+
+void StatementImpl::Set(int param, const std::string& s)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[string]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[string]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, s);
+}
+
+void StatementImpl::Set(int param, int16_t value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[int16_t]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[int16_t]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, int32_t value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[int32_t]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[int32_t]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, int64_t value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[int64_t]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[int64_t]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, float value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[float]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[float]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, double value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[double]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[double]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const IBPP::Timestamp& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Timestamp]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Timestamp]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const IBPP::Date& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Date]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Date]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const IBPP::Time& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Time]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Time]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const IBPP::Blob& blob)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Blob]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Blob]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, blob);
+}
+
+void StatementImpl::Set(int param, const IBPP::Array& array)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Array]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Array]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, array);
+}
+
+void StatementImpl::Set(int param, const IBPP::DBKey& key)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[DBKey]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[DBKey]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, key);
+}
+
+/*
+void StatementImpl::Set(int param, const IBPP::Value& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Value]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Value]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+*/
+
+bool StatementImpl::IsNull(int column)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::IsNull", _("The row is not initialized."));
+
+	return mOutRow->IsNull(column);
+}
+
+bool StatementImpl::Get(int column, bool* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(column, *retvalue);
+}
+
+bool StatementImpl::Get(int column, bool& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, char* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, void* bindata, int& userlen)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, bindata, userlen);
+}
+
+bool StatementImpl::Get(int column, std::string& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, int16_t* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(column, *retvalue);
+}
+
+bool StatementImpl::Get(int column, int16_t& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, int32_t* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(column, *retvalue);
+}
+
+bool StatementImpl::Get(int column, int32_t& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, int64_t* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(column, *retvalue);
+}
+
+bool StatementImpl::Get(int column, int64_t& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, float* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(column, *retvalue);
+}
+
+bool StatementImpl::Get(int column, float& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, double* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(column, *retvalue);
+}
+
+bool StatementImpl::Get(int column, double& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, retvalue);
+}
+
+bool StatementImpl::Get(int column, IBPP::Timestamp& timestamp)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, timestamp);
+}
+
+bool StatementImpl::Get(int column, IBPP::Date& date)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, date);
+}
+
+bool StatementImpl::Get(int column, IBPP::Time& time)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, time);
+}
+
+bool StatementImpl::Get(int column, IBPP::Blob& blob)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, blob);
+}
+
+bool StatementImpl::Get(int column, IBPP::DBKey& key)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, key);
+}
+
+bool StatementImpl::Get(int column, IBPP::Array& array)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, array);
+}
+
+/*
+const IBPP::Value StatementImpl::Get(int column)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column);
+}
+*/
+
+bool StatementImpl::IsNull(const std::string& name)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::IsNull", _("The row is not initialized."));
+
+	return mOutRow->IsNull(name);
+}
+
+bool StatementImpl::Get(const std::string& name, bool* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(name, *retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, bool& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, char* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get[char*]", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, void* retvalue, int& count)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get[void*,int]", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue, count);
+}
+
+bool StatementImpl::Get(const std::string& name, std::string& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::GetString", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, int16_t* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(name, *retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, int16_t& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, int32_t* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(name, *retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, int32_t& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, int64_t* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(name, *retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, int64_t& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, float* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(name, *retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, float& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, double* retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+	if (retvalue == 0)
+		throw LogicExceptionImpl("Statement::Get", _("Null pointer detected"));
+
+	return mOutRow->Get(name, *retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, double& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::Timestamp& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::Date& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::Time& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string&name, IBPP::Blob& retblob)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retblob);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::DBKey& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::Array& retarray)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retarray);
+}
+
+/*
+const IBPP::Value StatementImpl::Get(const std::string& name)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name);
+}
+*/
+
+int StatementImpl::Columns()
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
+
+	return mOutRow->Columns();
+}
+
+int StatementImpl::ColumnNum(const std::string& name)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ColumnNum", _("The row is not initialized."));
+
+	return mOutRow->ColumnNum(name);
+}
+
+IBPP::ColumnHandle StatementImpl::Column(const std::string& name)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Column", _("The row is not initialized."));
+
+	return mOutRow->Column(name);
+}
+
+const char* StatementImpl::ColumnName(int varnum)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
+
+	return mOutRow->ColumnName(varnum);
+}
+
+const char* StatementImpl::ColumnAlias(int varnum)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
+
+	return mOutRow->ColumnAlias(varnum);
+}
+
+const char* StatementImpl::ColumnTable(int varnum)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Columns", _("The row is not initialized."));
+
+	return mOutRow->ColumnTable(varnum);
+}
+
+IBPP::SDT StatementImpl::ColumnType(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ColumnType", _("No statement has been prepared."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ColumnType", _("The statement does not return results."));
+
+    return mOutRow->ColumnType(varnum);
+}
+
+int StatementImpl::ColumnSubtype(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ColumnSubtype", _("No statement has been prepared."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ColumnSubtype", _("The statement does not return results."));
+
+    return mOutRow->ColumnSubtype(varnum);
+}
+
+int StatementImpl::ColumnSize(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ColumnSize", _("No statement has been prepared."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ColumnSize", _("The row is not initialized."));
+
+	return mOutRow->ColumnSize(varnum);
+}
+
+int StatementImpl::ColumnScale(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ColumnScale", _("No statement has been prepared."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ColumnScale", _("The row is not initialized."));
+
+	return mOutRow->ColumnScale(varnum);
+}
+
+int StatementImpl::Parameters()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Parameters", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Parameters", _("The statement uses no parameters."));
+
+	return mInRow->Columns();
+}
+
+IBPP::SDT StatementImpl::ParameterType(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ParameterType", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::ParameterType", _("The statement uses no parameters."));
+
+    return mInRow->ColumnType(varnum);
+}
+
+int StatementImpl::ParameterSubtype(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ParameterSubtype", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::ParameterSubtype", _("The statement uses no parameters."));
+
+    return mInRow->ColumnSubtype(varnum);
+}
+
+int StatementImpl::ParameterSize(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ParameterSize", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::ParameterSize", _("The statement uses no parameters."));
+
+	return mInRow->ColumnSize(varnum);
+}
+
+int StatementImpl::ParameterScale(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ParameterScale", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::ParameterScale", _("The statement uses no parameters."));
+
+	return mInRow->ColumnScale(varnum);
+}
+
+IBPP::Database StatementImpl::DatabasePtr() const
+{
+	return mDatabase;
+}
+
+void StatementImpl::AttachTransaction(IBPP::Transaction tr)
+{
+	TransactionImpl* transaction = dynamic_cast<TransactionImpl*>(tr.intf());
+	if (transaction == 0)
+		throw LogicExceptionImpl("Statement::AttachTransaction",
+			_("Can't attach a 0 ITransaction object."));
+	if (transaction == mTransaction) return;
+	if (mDatabase != 0 && ! transaction->DatabaseAttached(mDatabase))
+		throw LogicExceptionImpl("Statement::AttachTransaction",
+			_("Transaction not attached to this Database."));
+
+	// A result set still open belongs to the previous transaction, which
+	// may have closed it already when it ended. The prepared statement itself
+	// can run under any transaction.
+	try { CursorFree(); }
+		catch (...) { }
+	mResultSetAvailable = false;
+	if (mRowPool != 0) { mRowPool->Drain(); mRowPool->Release(); mRowPool = 0; }
+
+	AttachTransactionImpl(transaction);
+
+	// Blobs and arrays read from the rows now belong to the new transaction
+	if (mInRow != 0) mInRow->SetTransaction(mTransaction);
+	if (mOutRow != 0) mOutRow->SetTransaction(mTransaction);
+	for (size_t i = 0; i < mBatchBlocks.size(); i++)
+		mBatchBlocks[i].second->AttachTransaction(tr);
+}
+
+IBPP::Transaction StatementImpl::TransactionPtr() const
+{
+	return mTransaction;
+}
+
+IBPP::IStatement* StatementImpl::AddRef()
+{
+	ASSERTION(mRefCount >= 0);
+	++mRefCount;
+
+	return this;
+}
+
+void StatementImpl::Release()
+{
+	// Release cannot throw, except in DEBUG builds on assertion
+	ASSERTION(mRefCount >= 0);
+	try { if (--mRefCount <= 0) delete this; }
+		catch (...) { }
+}
+
+//	(((((((( OBJECT INTERNAL METHODS ))))))))
+
+void StatementImpl::AttachDatabaseImpl(DatabaseImpl* database)
+{
+	if (database == 0)
+		throw LogicExceptionImpl("Statement::AttachDatabase",
+			_("Can't attach a 0 IDatabase object."));
+
+	if (mDatabase != 0) mDatabase->DetachStatementImpl(this);
+	mDatabase = database;
+	mDatabase->AttachStatementImpl(this);
+}
+
+void StatementImpl::DetachDatabaseImpl()
+{
+	if (mDatabase == 0) return;
+
+	Close();
+	mDatabase->DetachStatementImpl(this);
+	mDatabase = 0;
+}
+
+void StatementImpl::AttachTransactionImpl(TransactionImpl* transaction)
+{
+	if (transaction == 0)
+		throw LogicExceptionImpl("Statement::AttachTransaction",
+			_("Can't attach a 0 ITransaction object."));
+
+	if (mTransaction != 0) mTransaction->DetachStatementImpl(this);
+	mTransaction = transaction;
+	mTransaction->AttachStatementImpl(this);
+}
+
+void StatementImpl::DetachTransactionImpl()
+{
+	if (mTransaction == 0) return;
+
+	Close();
+	mTransaction->DetachStatementImpl(this);
+	mTransaction = 0;
+}
+
+const char* StatementImpl::ExecuteCall(const char* context, IBS& status, bool* singleton)
+{
+	THREADCHECK(mDatabase);
+	// Execute() of the prepared statement. A failure of the server is left in
+	// status and the failed call is returned, for the caller to either throw
+	// or return it. With singleton given (ExecuteSingleton()), a select reads
+	// its row into mOutRow without any cursor and singleton tells if found.
+	if (mHandle == 0)
+		throw LogicExceptionImpl(context, _("No statement has been prepared."));
+
+	// Check that a value has been set for each input parameter
+	if (mInRow != 0 && mInRow->MissingValues())
+		throw LogicExceptionImpl(context, _("All parameters must be specified."));
+
+	CursorFree();	// Free a previous 'cursor' if any
+
+	// The measure of SetPerfStats() ends with the result set, if any
+	mPerf.Begin(&mDatabase, 1);
+	QueryProfile* profile = Profile();
+	QueryTimer timer(profile, &QueryProfile::mExecute);
+	const char* failed = 0;
+	if (singleton != 0)
+	{
+		ISC_STATUS code = (*gds.Call()->m_dsql_execute2)(status.Self(),
+			mTransaction->GetHandlePtr(), &mHandle, 1,
+			mInRow == 0 ? 0 : mInRow->Self(), mOutRow->Self());
+		if (status.Errors()) failed = _("isc_dsql_execute2 failed");
+		*singleton = code != 100;	// This special code means "no row"
+	}
+	else if (mType == IBPP::stSelect)
+	{
+		// Could return a result set (none, single or multi rows)
+		(*gds.Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
+			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self());
+		if (status.Errors()) failed = _("isc_dsql_execute failed");
+		else if (mOutRow != 0)
+		{
+			mResultSetAvailable = true;
+			mCursorOpened = true;
+		}
+	}
+	else
+	{
+		// Should return at most a single row
+		(*gds.Call()->m_dsql_execute2)(status.Self(), mTransaction->GetHandlePtr(),
+			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self(),
+			mOutRow == 0 ? 0 : mOutRow->Self());
+		if (status.Errors()) failed = _("isc_dsql_execute2 failed");
+	}
+	timer.Stop();
+	if (! mResultSetAvailable) mPerf.End(&mDatabase, 1);
+	if (failed != 0) mCacheable = false;	// Don't recycle a statement in error
+
+	if (failed == 0 && profile != 0 && (mType == IBPP::stInsert
+		|| mType == IBPP::stUpdate || mType == IBPP::stDelete))
+		profile->mRowsAffected += AffectedRows();
+	return failed;
+}
+
+QueryProfile* StatementImpl::Profile()
+{
+	// The profile of mSql while IBPP::EnableQueryStats() is on, else 0. It
+	// is looked up once per prepared SQL, even when the stats get turned on
+	// after the Prepare().
+	if (! QueryProfile::mEnabled.load(std::memory_order_relaxed)) return 0;
+	if (mProfile == 0 && ! mSql.empty()) mProfile = QueryProfile::Find(mSql);
+	return mProfile;
+}
+
+int StatementImpl::FetchCall(IBS& status)
+{
+	// Fetch() of the next row into mOutRow, returns 100 at the end of the
+	// result set. A failure of the server is left in status, the statement
+	// is then closed.
+	int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
+	if (code == 100)	// This special code means "no more rows"
+	{
+		mResultSetAvailable = false;
+		// Oddly enough, fetching rows up to the last one seems to open
+		// an 'implicit' cursor that needs to be closed.
+		mCursorOpened = true;
+		CursorFree();	// Free the explicit or implicit cursor/result-set
+		return code;
+	}
+	if (status.Errors())
+	{
+		mCacheable = false;		// Don't recycle a statement in error
+		Close();
+	}
+	return code;
+}
+
+void StatementImpl::CursorFree()
+{
+	PrefetchStop();		// Its thread fetches through the cursor
+	mPerf.End(&mDatabase, 1);	// Done with the result set, see SetPerfStats()
+	mBatchEnded = false;
+	if (mCursorOpened)
+	{
+		mCursorOpened = false;
+		if (mHandle != 0)
+		{
+			IBS status;
+			(*gds.Call()->m_dsql_free_statement)(status.Self(), &mHandle, DSQL_close);
+			if (status.Errors())
+				throw SQLExceptionImpl(status, "StatementImpl::CursorFree(DSQL_close)",
+					_("isc_dsql_free_statement failed."));
+		}
+	}
+}
+
+RowImpl* StatementImpl::PrefetchNext(const char* context, IBS* failed)
+{
+	// Next prefetched row. At the end of the result set, or once the rows
+	// before a failed fetch are read, behaves as Fetch() would have. Unless
+	// failed is given, which then gets the status of the failed fetch.
+	IBS* error;
+	std::exception_ptr failure;
+	RowImpl* row = mPrefetch->Pop(error, failure);
+	if (row != 0) return row;
+
+	if (failure)
+	{
+		mCacheable = false;
+		Close();
+		std::rethrow_exception(failure);
+	}
+
+	if (error != 0)
+	{
+		IBS status(*error);
+		mCacheable = false;		// Don't recycle a statement in error
+		Close();
+		if (failed == 0)
+			throw SQLExceptionImpl(status, context, _("isc_dsql_fetch failed."));
+		*failed = status;
+		return 0;
+	}
+
+	mResultSetAvailable = false;
+	mCursorOpened = true;
+	CursorFree();	// Free the explicit or implicit cursor/result-set
+	return 0;
+}
+
+void StatementImpl::PrefetchStop()
+{
+	if (mPrefetch == 0) return;
+	mPrefetch->Stop();
+	mPrefetch->Statistics(&mPrefetchStats[0], &mPrefetchStats[1], &mPrefetchStats[2]);
+	delete mPrefetch;
+	mPrefetch = 0;
+}
+
+void StatementImpl::Unprepare()
+{
+	// Readies the statement for another Prepare(). With the database cache
+	// on, the prepared statement goes there. Otherwise the statement handle
+	// and both descriptors are kept : isc_dsql_prepare() can be called again
+	// on the same handle once its cursor is closed.
+	if (mHandle == 0 || mDatabase == 0 || mDatabase->StatementCacheSize() > 0)
+	{
+		Close();
+		return;
+	}
+
+	try { CursorFree(); }
+	catch (...)
+	{
+		mCacheable = false;
+		Close();
+		return;
+	}
+
+	if (mRowPool != 0) { mRowPool->Drain(); mRowPool->Release(); mRowPool = 0; }
+	BatchFree();
+
+	mResultSetAvailable = false;
+	mCursorOpened = false;
+	mCacheable = false;
+	mType = IBPP::stUnknown;
+	mBatchCopies.clear();
+	mBatchEnded = false;
+}
+
+void StatementImpl::SizeRow(RowImpl*& row, int columns)
+{
+	// Creates, resizes or releases a descriptor to a count of columns
+	if (columns == 0)
+	{
+		if (row != 0) { row->Release(); row = 0; }
+		return;
+	}
+
+	if (row == 0)
+	{
+		row = new RowImpl(mDatabase->Dialect(), columns, mDatabase, mTransaction);
+		row->AddRef();
+	}
+	else
+	{
+		row->Resize(columns);
+		row->SetTransaction(mTransaction);
+	}
+	row->Self()->sqld = (short)columns;
+}
+
+//	Copies a name out of an isc_dsql_sql_info() answer into an XSQLVAR
+static void InfoName(char* name, size_t size, ISC_SHORT& length, const char* data, int len)
+{
+	if (len > (int)size) len = (int)size;
+	memcpy(name, data, len);
+	if (len < (int)size) name[len] = '\0';
+	length = (ISC_SHORT)len;
+}
+
+bool StatementImpl::DescribeFromInfo(char*& p, char section, RowImpl*& row)
+{
+	// Fills one descriptor (isc_info_sql_select or isc_info_sql_bind section)
+	// from an isc_dsql_sql_info() answer, and moves p past that section.
+	// Returns false if the answer is incomplete.
+	if (p[0] != section || p[1] != isc_info_sql_describe_vars) return false;
+	int len = (*gds.Call()->m_vax_integer)(p+2, 2);
+	int count = (*gds.Call()->m_vax_integer)(p+4, (short)len);
+	p += 4 + len;
+
+	SizeRow(row, count);
+
+	XSQLVAR* var = 0;
+	for (;;)
+	{
+		char item = *p;
+		if (item == isc_info_end || item == isc_info_sql_select
+			|| item == isc_info_sql_bind) break;
+		if (item == isc_info_truncated) return false;
+		if (item == isc_info_sql_describe_end) { ++p; continue; }
+
+		len = (*gds.Call()->m_vax_integer)(p+1, 2);
+		char* data = p + 3;
+		p += 3 + len;
+
+		if (item == isc_info_sql_sqlda_seq)
+		{
+			int seq = (*gds.Call()->m_vax_integer)(data, (short)len);
+			if (seq < 1 || seq > count) return false;
+			var = &(row->Self()->sqlvar[seq-1]);
+			continue;
+		}
+		if (var == 0) return false;
+
+		switch (item)
+		{
+			case isc_info_sql_type :
+				var->sqltype = (ISC_SHORT)(*gds.Call()->m_vax_integer)(data, (short)len); break;
+			case isc_info_sql_sub_type :
+				var->sqlsubtype = (ISC_SHORT)(*gds.Call()->m_vax_integer)(data, (short)len); break;
+			case isc_info_sql_scale :
+				var->sqlscale = (ISC_SHORT)(*gds.Call()->m_vax_integer)(data, (short)len); break;
+			case isc_info_sql_length :
+				var->sqllen = (ISC_SHORT)(*gds.Call()->m_vax_integer)(data, (short)len); break;
+			case isc_info_sql_field :
+				InfoName(var->sqlname, sizeof(var->sqlname), var->sqlname_length, data, len); break;
+			case isc_info_sql_relation :
+				InfoName(var->relname, sizeof(var->relname), var->relname_length, data, len); break;
+			case isc_info_sql_owner :
+				InfoName(var->ownname, sizeof(var->ownname), var->ownname_length, data, len); break;
+			case isc_info_sql_alias :
+				InfoName(var->aliasname, sizeof(var->aliasname), var->aliasname_length, data, len); break;
+			default : return false;
+		}
+	}
+	return true;
+}
+
+void StatementImpl::Describe(RowImpl*& row, bool input)
+{
+	// Describes the output columns or the input parameters through the
+	// describe calls, with a larger descriptor when the first was too small.
+	SizeRow(row, row == 0 ? 1 : row->AllocatedSize());
+	for (;;)
+	{
+		IBS status;
+		if (input)
+			(*gds.Call()->m_dsql_describe_bind)(status.Self(), &mHandle, 1, row->Self());
+		else (*gds.Call()->m_dsql_describe)(status.Self(), &mHandle, 1, row->Self());
+		if (status.Errors())
+		{
+			Close();
+			throw SQLExceptionImpl(status, "Statement::Prepare", input ?
+				_("isc_dsql_describe_bind failed") : _("isc_dsql_describe failed"));
+		}
+		if (row->Columns() <= row->AllocatedSize()) break;
+		row->Resize(row->Columns());
+	}
+	if (row->Columns() == 0) SizeRow(row, 0);
+}
+
+void StatementImpl::BatchDescribe()
+{
+	// Decides, once the statement is prepared, how each output column is
+	// copied into a ColumnBatch.
+	mBatchCopies.clear();
+	mBatchEnded = false;
+	if (mOutRow == 0) return;
+	for (int i = 0; i < mOutRow->Columns(); i++)
+	{
+		XSQLVAR* var = &(mOutRow->Self()->sqlvar[i]);
+		BatchCopy copy;
+		switch (var->sqltype & ~1)
+		{
+			case SQL_SHORT :		copy = bkInt16; break;
+			case SQL_LONG :			copy = bkInt32; break;
+			case SQL_INT64 :		copy = bkInt64; break;
+			case SQL_FLOAT :		copy = bkFloat; break;
+			case SQL_DOUBLE :		copy = bkDouble; break;
+			case SQL_TYPE_DATE :	copy = bkDate; break;
+			case SQL_TYPE_TIME :	copy = bkTime; break;
+			case SQL_TIMESTAMP :	copy = bkTimestamp; break;
+			case SQL_TEXT :			copy = bkText; break;
+			case SQL_VARYING :		copy = bkVarying; break;
+			default :				copy = bkNone; break;
+		}
+		mBatchCopies.push_back(copy);
+	}
+}
+
+void StatementImpl::BatchSetup(IBPP::ColumnBatch& batch)
+{
+	// (Re)shapes the batch for our columns, if it was used elsewhere
+	for (size_t i = 0; i < mBatchCopies.size(); i++)
+		if (mBatchCopies[i] == bkNone)
+			throw LogicExceptionImpl("Statement::FetchBatch",
+				_("Blob or array column %d, use Fetch() instead."), (int)i+1);
+
+	static const IBPP::BCT types[] = {IBPP::bcInt16, IBPP::bcInt32,
+		IBPP::bcInt64, IBPP::bcFloat, IBPP::bcDouble, IBPP::bcDate,
+		IBPP::bcTime, IBPP::bcTimestamp, IBPP::bcString, IBPP::bcString};
+
+	batch.mRows = 0;
+	batch.mColumns.resize(mBatchCopies.size());
+	for (size_t i = 0; i < mBatchCopies.size(); i++)
+	{
+		IBPP::ColumnBatch::Column& c = batch.mColumns[i];
+		c.type = types[mBatchCopies[i]];
+		c.scale = (c.type == IBPP::bcInt16 || c.type == IBPP::bcInt32
+			|| c.type == IBPP::bcInt64) ? -mOutRow->Self()->sqlvar[i].sqlscale : 0;
+		if (c.type != IBPP::bcString) c.offsets.clear();
+	}
+}
+
+void StatementImpl::BatchFree()
+{
+	ClearBatch();
+	for (size_t i = 0; i < mBatchBlocks.size(); i++)
+		mBatchBlocks[i].second->Release();
+	mBatchBlocks.clear();
+	mBatchBlocksFailed = false;
+}
+
+void StatementImpl::AddBatch(RowImpl* row)
+{
+	// A row of parameters shaped as ours, the copy is up to the caller
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::AddBatch", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::AddBatch", _("The statement does not take parameters."));
+	if (row->Self()->sqld != mInRow->Self()->sqld || row->BufferSize() != mInRow->BufferSize())
+		throw LogicExceptionImpl("Statement::AddBatch", _("The row does not match the parameters."));
+	if (row->MissingValues())
+		throw LogicExceptionImpl("Statement::AddBatch", _("All parameters must be specified."));
+
+	row->AddRef();
+	mBatch.push_back(row);
+}
+
+int StatementImpl::BatchChunk(int rows)
+{
+	// Count of rows per EXECUTE BLOCK, or 0 when this statement can't be run
+	// that way : no parameter, output columns (or RETURNING), dialect 1, an
+	// array parameter, or a server which already refused such a block.
+	if (mBatchBlocksFailed || mInRow == 0 || mOutRow != 0
+		|| mDatabase->Dialect() != 3) return 0;
+	if (mType != IBPP::stInsert && mType != IBPP::stUpdate
+		&& mType != IBPP::stDelete && mType != IBPP::stExecProcedure) return 0;
+
+	// Rough size, for each row, of the block text and of its parameters
+	// message, both of which are limited to 64 KB by the server
+	XSQLDA* da = mInRow->Self();
+	int text = (int)mSql.length() + 32;
+	int message = 8;
+	for (int i = 0; i < da->sqld; i++)
+	{
+		if ((da->sqlvar[i].sqltype & ~1) == SQL_ARRAY) return 0;
+		text += 64;
+		message += da->sqlvar[i].sqllen + 8;
+	}
+
+	if (rows == 0) rows = 64;
+	if (rows > 60000 / text) rows = 60000 / text;
+	if (rows > 60000 / message) rows = 60000 / message;
+	return rows > 1 ? rows : 0;
+}
+
+//	Character set of a described CHAR or VARCHAR (the low byte of its sqlsubtype)
+//	and its maximum bytes per character. 0 if not known here.
+static const char* BlockCharset(int id, int& bytes)
+{
+	static const struct { int id; const char* name; int bytes; } charsets[] = {
+		{0, "NONE", 1}, {1, "OCTETS", 1}, {2, "ASCII", 1}, {3, "UNICODE_FSS", 3},
+		{4, "UTF8", 4}, {5, "SJIS_0208", 2}, {6, "EUCJ_0208", 2},
+		{9, "DOS737", 1}, {10, "DOS437", 1}, {11, "DOS850", 1}, {12, "DOS865", 1},
+		{13, "DOS860", 1}, {14, "DOS863", 1}, {15, "DOS775", 1}, {16, "DOS858", 1},
+		{17, "DOS862", 1}, {18, "DOS864", 1}, {19, "NEXT", 1},
+		{21, "ISO8859_1", 1}, {22, "ISO8859_2", 1}, {23, "ISO8859_3", 1},
+		{34, "ISO8859_4", 1}, {35, "ISO8859_5", 1}, {36, "ISO8859_6", 1},
+		{37, "ISO8859_7", 1}, {38, "ISO8859_8", 1}, {39, "ISO8859_9", 1},
+		{40, "ISO8859_13", 1}, {44, "KSC_5601", 2}, {45, "DOS852", 1},
+		{46, "DOS857", 1}, {47, "DOS861", 1}, {48, "DOS866", 1}, {49, "DOS869", 1},
+		{50, "CYRL", 1}, {51, "WIN1250", 1}, {52, "WIN1251", 1}, {53, "WIN1252", 1},
+		{54, "WIN1253", 1}, {55, "WIN1254", 1}, {56, "BIG_5", 2}, {57, "GB_2312", 2},
+		{58, "WIN1255", 1}, {59, "WIN1256", 1}, {60, "WIN1257", 1}, {63, "KOI8R", 1},
+		{64, "KOI8U", 1}, {65, "WIN1258", 1}, {66, "TIS620", 1}, {67, "GBK", 2},
+		{68, "CP943C", 2}, {69, "GB18030", 4}};
+
+	for (size_t i = 0; i < sizeof(charsets) / sizeof(charsets[0]); i++)
+		if (charsets[i].id == id)
+		{
+			bytes = charsets[i].bytes;
+			return charsets[i].name;
+		}
+	return 0;
+}
+
+//	Type of a parameter of the EXECUTE BLOCK, which is the type described for
+//	the parameter of the statement (so both are stored exactly the same way).
+//	An empty string if there is no such type.
+static std::string BlockParameterType(const XSQLVAR* var)
+{
+	const char* charset;
+	static const char* ints[] = {"SMALLINT", "INTEGER", "BIGINT"};
+	static const int digits[] = {4, 9, 18};
+	std::ostringstream type;
+	int size, bytes;
+	switch (var->sqltype & ~1)
+	{
+		case SQL_SHORT :
+		case SQL_LONG :
+		case SQL_INT64 :
+			size = (var->sqltype & ~1) == SQL_SHORT ? 0 : (var->sqltype & ~1) == SQL_LONG ? 1 : 2;
+			if (var->sqlscale == 0) type<< ints[size];
+			else type<< "NUMERIC("<< digits[size]<< ","<< -var->sqlscale<< ")";
+			break;
+		case SQL_FLOAT :		type<< "FLOAT"; break;
+		case SQL_DOUBLE :		type<< "DOUBLE PRECISION"; break;
+		case SQL_TIMESTAMP :	type<< "TIMESTAMP"; break;
+		case SQL_TYPE_DATE :	type<< "DATE"; break;
+		case SQL_TYPE_TIME :	type<< "TIME"; break;
+		case SQL_TEXT :
+		case SQL_VARYING :
+			// The described character set, the length being counted in characters
+			charset = BlockCharset(var->sqlsubtype & 0xFF, bytes);
+			if (charset == 0 || var->sqllen % bytes != 0) break;
+			type<< ((var->sqltype & ~1) == SQL_TEXT ? "CHAR(" : "VARCHAR(")
+				<< var->sqllen / bytes<< ") CHARACTER SET "<< charset;
+			break;
+		case SQL_BLOB :			type<< "BLOB SUB_TYPE "<< var->sqlsubtype; break;
+		default :				break;
+	}
+	return type.str();
+}
+
+std::string StatementImpl::BatchBlockSql(int rows)
+{
+	// EXECUTE BLOCK (P0_0 type = ?, ...) RETURNS (R0 INTEGER, ...) AS BEGIN
+	// <statement with :P0_0 ...>; R0 = ROW_COUNT; ... END
+	XSQLDA* da = mInRow->Self();
+	std::ostringstream params, returns, body;
+	for (int r = 0; r < rows; r++)
+	{
+		int param = 0;
+		for (int i = 0; i < da->sqld; i++)
+		{
+			std::string type = BlockParameterType(&da->sqlvar[i]);
+			if (type.empty()) return std::string();
+			params<< (r+i == 0 ? "" : ", ")<< "P"<< r<< "_"<< i<< " "<< type<< " = ?";
+		}
+		returns<< (r == 0 ? "" : ", ")<< "R"<< r<< " INTEGER";
+
+		// The statement, its '?' replaced by the parameters of this row.
+		// String constants, quoted identifiers and comments are skipped.
+		for (size_t i = 0; i < mSql.length(); i++)
+		{
+			char c = mSql[i];
+			size_t end = i;
+			if (c == '\'' || c == '"')
+				end = mSql.find(c, i+1);
+			else if (c == '/' && i+1 < mSql.length() && mSql[i+1] == '*')
+			{
+				end = mSql.find("*/", i+2);
+				if (end != std::string::npos) ++end;
+			}
+			else if (c == '-' && i+1 < mSql.length() && mSql[i+1] == '-')
+			{
+				// Line comments are dropped, they would hide what follows
+				end = mSql.find('\n', i);
+				if (end == std::string::npos) break;
+				i = end - 1;
+				continue;
+			}
+			else if (c == '?')
+			{
+				body<< ":P"<< r<< "_"<< param++;
+				continue;
+			}
+			if (end == std::string::npos) end = mSql.length() - 1;
+			body<< mSql.substr(i, end - i + 1);
+			i = end;
+		}
+		body<< ";\nR"<< r<< " = ROW_COUNT;\n";
+	}
+
+	std::string sql = "EXECUTE BLOCK (";
+	sql.append(params.str()).append(")\nRETURNS (").append(returns.str())
+		.append(")\nAS BEGIN\n").append(body.str()).append("END");
+	return sql;
+}
+
+bool StatementImpl::BatchRunBlock(int first, int count, std::vector<int>& affected)
+{
+	// Runs count rows of the batch as one EXECUTE BLOCK, prepared once per
+	// count of rows. Returns false when the block could not be run.
+	StatementImpl* block = 0;
+	for (size_t i = 0; i < mBatchBlocks.size(); i++)
+		if (mBatchBlocks[i].first == count) block = mBatchBlocks[i].second;
+
+	if (block == 0)
+	{
+		std::string sql = BatchBlockSql(count);
+		if (sql.empty()) { mBatchBlocksFailed = true; return false; }
+
+		block = new StatementImpl(mDatabase, mTransaction, std::string());
+		block->AddRef();
+		try { block->Prepare(sql); }
+		catch (IBPP::SQLException&)
+		{
+			// Most probably a server older than Firebird 2.0
+			block->Release();
+			mBatchBlocksFailed = true;
+			return false;
+		}
+		mBatchBlocks.push_back(std::make_pair(count, block));
+	}
+
+	const int params = mInRow->Columns();
+	for (int r = 0; r < count; r++)
+		for (int i = 1; i <= params; i++)
+			if (! block->mInRow->CopyColumn(r * params + i, *mBatch[first + r], i))
+			{
+				mBatchBlocksFailed = true;
+				return false;
+			}
+
+	try { block->Execute(); }
+	catch (IBPP::SQLException&) { return false; }
+
+	for (int r = 0; r < count; r++)
+	{
+		int32_t rows = 0;
+		block->mOutRow->Get(r+1, rows);
+		affected[first + r] = rows;
+	}
+	return true;
+}
+
+void StatementImpl::BatchRunSplit(int first, int count, std::vector<int>& affected,
+	std::vector<IBPP::BatchError>& errors)
+{
+	// Runs count rows of the batch as one block. The server runs each block
+	// under its own savepoint, undone when it fails : the halves of a failed
+	// block are then run the same way, down to a couple of rows, run one by
+	// one. A single bad row among n costs about 2 log2(n) blocks instead of n
+	// statements.
+	if (count <= 2)
+	{
+		BatchRunRows(first, count, affected, errors);
+		return;
+	}
+	if (BatchRunBlock(first, count, affected)) return;
+	if (mBatchBlocksFailed)
+	{
+		BatchRunRows(first, count, affected, errors);
+		return;
+	}
+
+	const int half = count / 2;
+	BatchRunSplit(first, half, affected, errors);
+	BatchRunSplit(first + half, count - half, affected, errors);
+}
+
+void StatementImpl::BatchRunRows(int first, int count, std::vector<int>& affected,
+	std::vector<IBPP::BatchError>& errors)
+{
+	// The rows of the batch go through mInRow, which holds the parameters
+	// currently Set() by the caller : they are put back once done.
+	RowImpl saved(*mInRow);
+	try
+	{
+		for (int r = first; r < first + count; r++)
+		{
+			*mInRow = *mBatch[r];
+			try
+			{
+				Execute();
+				affected[r] = AffectedRows();
+			}
+			catch (IBPP::SQLException& e)
+			{
+				IBPP::BatchError error;
+				error.row = r;
+				error.sqlcode = e.SqlCode();
+				error.enginecode = e.EngineCode();
+				error.message = e.what();
+				errors.push_back(error);
+			}
+		}
+	}
+	catch (...)
+	{
+		*mInRow = saved;
+		throw;
+	}
+	*mInRow = saved;
+}
+
+StatementImpl::StatementImpl(DatabaseImpl* database, TransactionImpl* transaction,
+	const std::string& sql)
+	: mRefCount(0), mHandle(0), mDatabase(0), mTransaction(0),
+	mInRow(0), mOutRow(0), mRowPool(0), mPrefetch(0), mProfile(0), mPrefetchStats(),
+	mResultSetAvailable(false), mCursorOpened(false), mCacheable(false),
+	mType(IBPP::stUnknown), mBatchEnded(false), mBatchBlocksFailed(false)
+{
+	AttachDatabaseImpl(database);
+	if (transaction != 0) AttachTransactionImpl(transaction);
+	if (! sql.empty()) Prepare(sql);
+}
+
+StatementImpl::~StatementImpl()
+{
+	try { Close(); }
+		catch (...) { }
+	try { if (mTransaction != 0) mTransaction->DetachStatementImpl(this); }
+		catch (...) { }
+	try { if (mDatabase != 0) mDatabase->DetachStatementImpl(this); }
+		catch (...) { }
+}
+
+//
+//	EOF
+//
@@ -44,13 +44,14 @@ using namespace ibpp_internals;
 //	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
 
 void TransactionImpl::AttachDatabase(IBPP::Database db,
-	IBPP::TAM am, IBPP::TIL il, IBPP::TLR lr, IBPP::TFF flags)
+	IBPP::TAM am, IBPP::TIL il, IBPP::TLR lr, IBPP::TFF flags, int lockTimeout)
 {
 	if (db.intf() == 0)
 		throw LogicExceptionImpl("Transaction::AttachDatabase",
 				_("Can't attach an unbound Database."));
 
-	AttachDatabaseImpl(dynamic_cast<DatabaseImpl*>(db.intf()), am, il, lr, flags);
+	AttachDatabaseImpl(dynamic_cast<DatabaseImpl*>(db.intf()), am, il, lr, flags,
+		lockTimeout);
 }
 
 void TransactionImpl::DetachDatabase(IBPP::Database db)
@@ -114,6 +115,7 @@ void TransactionImpl::AddReservation(IBPP::Database db,
 
 void TransactionImpl::Start()
 {
+	THREADCHECK(mDatabases);
 	if (mHandle != 0) return;	// Already started anyway
 
 	if (mDatabases.empty())
@@ -153,31 +155,37 @@ void TransactionImpl::Start()
 
 void TransactionImpl::Commit()
 {
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Transaction::Commit", _("Transaction is not started."));
-		
 	IBS status;
-
-	(*gds.Call()->m_commit_transaction)(status.Self(), &mHandle);
-	if (status.Errors())
+	if (! CommitCall("Transaction::Commit", status, false))
 		throw SQLExceptionImpl(status, "Transaction::Commit");
-	mHandle = 0;	// Should be, better be sure
 }
 
 void TransactionImpl::CommitRetain()
 {
-	if (mHandle == 0)
-		throw LogicExceptionImpl("Transaction::CommitRetain", _("Transaction is not started."));
+	IBS status;
+	if (! CommitCall("Transaction::CommitRetain", status, true))
+		throw SQLExceptionImpl(status, "Transaction::CommitRetain");
+}
 
+IBPP::Status TransactionImpl::TryCommit()
+{
 	IBS status;
+	if (! CommitCall("Transaction::TryCommit", status, false))
+		return IBPP::Status(status.Self(), "Transaction::TryCommit");
+	return IBPP::Status();
+}
 
-	(*gds.Call()->m_commit_retaining)(status.Self(), &mHandle);
-	if (status.Errors())
-		throw SQLExceptionImpl(status, "Transaction::CommitRetain");
+IBPP::Status TransactionImpl::TryCommitRetain()
+{
+	IBS status;
+	if (! CommitCall("Transaction::TryCommitRetain", status, true))
+		return IBPP::Status(status.Self(), "Transaction::TryCommitRetain");
+	return IBPP::Status();
 }
 
 void TransactionImpl::Rollback()
 {
+	THREADCHECK(mDatabases);
 	if (mHandle == 0) return;	// Transaction not started anyway
 
 	IBS status;
@@ -190,6 +198,7 @@ void TransactionImpl::Rollback()
 
 void TransactionImpl::RollbackRetain()
 {
+	THREADCHECK(mDatabases);
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Transaction::RollbackRetain", _("Transaction is not started."));
 
@@ -211,13 +220,29 @@ void TransactionImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
 //	(((((((( OBJECT INTERNAL METHODS ))))))))
 
+bool TransactionImpl::CommitCall(const char* context, IBS& status, bool retain)
+{
+	THREADCHECK(mDatabases);
+	// Commit() or CommitRetain(). A failure of the server is left in status,
+	// for the caller to either throw it or return it as a Status.
+	if (mHandle == 0)
+		throw LogicExceptionImpl(context, _("Transaction is not started."));
+
+	mPerf.Begin(mDatabases.data(), mDatabases.size());
+	if (retain) (*gds.Call()->m_commit_retaining)(status.Self(), &mHandle);
+	else (*gds.Call()->m_commit_transaction)(status.Self(), &mHandle);
+	mPerf.End(mDatabases.data(), mDatabases.size());
+	if (status.Errors()) return false;
+	if (! retain) mHandle = 0;	// Should be, better be sure
+	return true;
+}
+
 void TransactionImpl::Init()
 {
 	mHandle = 0;
@@ -283,7 +308,7 @@ void TransactionImpl::DetachArrayImpl(ArrayImpl* ar)
 }
 
 void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
-	IBPP::TAM am, IBPP::TIL il, IBPP::TLR lr, IBPP::TFF flags)
+	IBPP::TAM am, IBPP::TIL il, IBPP::TLR lr, IBPP::TFF flags, int lockTimeout)
 {
 	if (mHandle != 0)
 		throw LogicExceptionImpl("Transaction::AttachDatabase",
@@ -291,6 +316,9 @@ void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
 	if (dbi == 0)
 		throw LogicExceptionImpl("Transaction::AttachDatabase",
 				_("Can't attach a null Database."));
+	if (lockTimeout < 0 || (lockTimeout > 0 && lr == IBPP::lrNoWait))
+		throw LogicExceptionImpl("Transaction::AttachDatabase",
+				_("Invalid lock timeout %d, it needs lrWait."), lockTimeout);
 
 	mDatabases.push_back(dbi);
 
@@ -311,6 +339,7 @@ void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
 
     if (lr == IBPP::lrNoWait) tpb->Insert(isc_tpb_nowait);
     else tpb->Insert(isc_tpb_wait);
+	if (lockTimeout > 0) tpb->Insert(isc_tpb_lock_timeout, lockTimeout);
 
 	if (flags & IBPP::tfIgnoreLimbo)	tpb->Insert(isc_tpb_ignore_limbo);
 	if (flags & IBPP::tfAutoCommit)		tpb->Insert(isc_tpb_autocommit);
@@ -346,12 +375,17 @@ void TransactionImpl::DetachDatabaseImpl(DatabaseImpl* dbi)
 	dbi->DetachTransactionImpl(this);
 }
 
+bool TransactionImpl::DatabaseAttached(DatabaseImpl* dbi) const
+{
+	return std::find(mDatabases.begin(), mDatabases.end(), dbi) != mDatabases.end();
+}
+
 TransactionImpl::TransactionImpl(DatabaseImpl* db,
-	IBPP::TAM am, IBPP::TIL il, IBPP::TLR lr, IBPP::TFF flags)
+	IBPP::TAM am, IBPP::TIL il, IBPP::TLR lr, IBPP::TFF flags, int lockTimeout)
 	: mRefCount(0)
 {
 	Init();
-	AttachDatabaseImpl(db, am, il, lr, flags);
+	AttachDatabaseImpl(db, am, il, lr, flags, lockTimeout);
 }
 
 TransactionImpl::~TransactionImpl()
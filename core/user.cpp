@@ -56,6 +56,17 @@ void IBPP::User::copyfrom(const IBPP::User& r)
 	groupid = r.groupid;
 }
 
+void IBPP::User::movefrom(IBPP::User& r)
+{
+	username.swap(r.username);
+	password.swap(r.password);
+	firstname.swap(r.firstname);
+	middlename.swap(r.middlename);
+	lastname.swap(r.lastname);
+	userid = r.userid;
+	groupid = r.groupid;
+}
+
 //	Public implementation
 
 void IBPP::User::clear()
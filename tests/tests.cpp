@@ -62,7 +62,10 @@
 
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 #include <typeinfo>
+#include <new>
+#include <atomic>
 
 // Fix to famous MSVC 6 variable scope bug
 #if defined(_MSC_VER) && (_MSC_VER < 1300)	// MSVC 6 should be < 1300
@@ -92,6 +95,25 @@
 const std::string UserName = "SYSDBA";
 const std::string Password = "masterkey";
 
+//	Counts the heap allocations of the whole program, which lets some tests
+//	report how many of them a given operation costs. Some tests allocate
+//	from several threads, hence the atomic count.
+
+static std::atomic<unsigned long> AllocCount(0);
+
+void* operator new(size_t size)
+{
+	AllocCount.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == 0) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
 class Test
 {
 	// Class 'Test' drives all the tests of this module.
@@ -107,6 +129,9 @@ class Test
 	void Test6();
 	void Test7();
 	void Test8();
+	void Test9();
+	void Test10();
+	void Test11();
 
 public:
 	void RunTests();
@@ -148,6 +173,9 @@ void Test::RunTests()
 				case 6 :	Test6(); break;
 				case 7 :	Test7(); break;
 				case 8 :	Test8(); break;
+				case 9 :	Test9(); break;
+				case 10 :	Test10(); break;
+				case 11 :	Test11(); break;
 				default :	return;		// All tests have been run
 			}
 		}
@@ -377,6 +405,10 @@ void Test::Test3()
 							"TB CHAR(40) CHARACTER SET OCTETS, "
 							"VB VARCHAR(40) CHARACTER SET OCTETS)");
 	tr1->CommitRetain();
+	st1->ExecuteImmediate(	"CREATE TABLE BULK("
+							"ID INTEGER, "
+							"NAME VARCHAR(20))");
+	tr1->CommitRetain();
 	st1->ExecuteImmediate(	"CREATE VIEW PRODUCT(X, Y) AS "
 							"SELECT T.N2, S.N2 FROM TEST T, TEST S"
 							);
@@ -835,6 +867,17 @@ void Test::Test5()
 		//printf("%g, %g\n", n2, n6);
 	}
 
+	// Same, as a singleton, then a singleton which finds its row
+	if (st1->ExecuteSingleton())
+	{
+		_Success = false;
+		printf(_("Statement::ExecuteSingleton() returned a row when there is none.\n"));
+	}
+	if (! st1->ExecuteSingleton("select count(*) from test"))
+	{
+		_Success = false;
+		printf(_("Statement::ExecuteSingleton() returned no row for a count.\n"));
+	}
 
     //	printf(_("Executing 10 times an Execute, Prepared once...\n"));
 	st1->Prepare("select N2, N6 from test");
@@ -858,17 +901,82 @@ void Test::Test5()
 	while (st1->Fetch(r))
 		rows.push_back(r);
 
+	IBPP::ColumnHandle hn6 = st1->Column("n6");
+	if (hn6 != 2)
+	{
+		_Success = false;
+		printf(_("Statement::Column(\"n6\") returned column %d while 2 was expected.\n"),
+			(int)hn6);
+	}
 	for (unsigned i = 0; i < rows.size(); i++)
 	{
 		double n2, n6;
 		rows[i]->Get(1, n2);
-		rows[i]->Get(2, n6);
+		rows[i]->Get(hn6, n6);
 		//printf("%g, %g\n", n2, n6);
 	}
 
 	// The rows vector will be deleted when function returns, which
 	// will release all individual rows and their storage. Check for leaks !
 
+	// Rows read one after the other are recycled by the statement : once the
+	// first row is taken from the pool, the next ones cost no allocation.
+	int fetched = 0;
+	st1->Execute("select N2, N6 from test");
+	unsigned long allocs = AllocCount;
+	if (st1->Fetch(r))
+	{
+		++fetched;
+		allocs = AllocCount;
+		while (st1->Fetch(r))
+			++fetched;
+	}
+	if (fetched > 1 && AllocCount != allocs)
+	{
+		_Success = false;
+		printf(_("Fetch(Row&) made %lu heap allocations after the first of %d rows.\n"),
+			AllocCount.load() - allocs, fetched);
+	}
+
+	// Same result set, read by batches of 16 rows into columns
+	IBPP::ColumnBatch batch;
+	unsigned batched = 0;
+	st1->Execute("select N2, N6 from test");
+	while (st1->FetchBatch(batch, 16) > 0)
+	{
+		if (batch.Columns() != 2 || batch.Rows() > 16)
+		{
+			_Success = false;
+			printf(_("Statement::FetchBatch() returned a malformed batch.\n"));
+			break;
+		}
+		batched += batch.Rows();
+	}
+	if (batched != rows.size())
+	{
+		_Success = false;
+		printf(_("Statement::FetchBatch() read %u rows instead of %u.\n"),
+			batched, (unsigned)rows.size());
+	}
+
+	// With the statement cache on, a second Statement preparing the same SQL
+	// takes the prepared statement left by the first one
+	int hits, misses;
+	db1->SetStatementCacheSize(8);
+	{
+		IBPP::Statement st2 = IBPP::StatementFactory(db1, tr1, "select count(*) from test");
+	}
+	IBPP::Statement st3 = IBPP::StatementFactory(db1, tr1, "select count(*) from test");
+	db1->StatementCacheStatistics(&hits, &misses, 0);
+	if (hits != 1 || misses != 1)
+	{
+		_Success = false;
+		printf(_("Statement cache counted %d hits and %d misses instead of 1 and 1.\n"),
+			hits, misses);
+	}
+	st3->Close();
+	db1->SetStatementCacheSize(0);
+
 	// Now, run a select, fetch all but the last row
 	st1->Execute("select N2, N6 from test");
 	for (unsigned i = 0; i < rows.size()-1; i++)
@@ -1156,7 +1264,488 @@ void Test::Test8()
 		ev->Dispatch();
 		Sleep(50);
 	}
+}
+
+void Test::Test9()
+{
+	printf(_("Test 9 --- Batches, rebound statements and lock conflicts\n"));
+
+	IBPP::Database db1;
+	db1 = IBPP::DatabaseFactory(ServerName, DbName, UserName, Password);
+	db1->Connect();
+
+	// Test 7 emptied TEST and Test 8 left a few rows without ID in it : this
+	// test and the next ones work on 100 fresh rows, of ID 0 to 99
+	IBPP::Transaction tr1 = IBPP::TransactionFactory(db1);
+	tr1->Start();
+	IBPP::Statement st1 = IBPP::StatementFactory(db1, tr1);
+	st1->ExecuteImmediate("delete from test");
+	st1->Prepare("insert into test(ID, N2, N6) values(?, ?, ?)");
+	for (int32_t id = 0; id < 100; id++)
+	{
+		st1->Set(1, id);
+		st1->Set(2, id / 4.0);
+		st1->Set(3, id * 1000.0);
+		st1->Execute();
+	}
+	int32_t total = 0;
+	st1->Execute("select count(*) from test");
+	if (st1->Fetch()) st1->Get(1, total);
+
+	// A batch of updates which change nothing, the last one matching no row
+	IBPP::Statement st2 = IBPP::StatementFactory(db1, tr1,
+		"update test set N2 = N2 where ID = ?");
+	for (int id = 0; id < 5; id++)
+	{
+		st2->Set(1, id == 4 ? -1 : id);
+		st2->AddBatch();
+	}
+	std::vector<int> affected;
+	std::vector<IBPP::BatchError> errors;
+	st2->ExecuteBatch(affected, errors);
+	if (affected.size() != 5 || affected[0] != 1 || affected[4] != 0 || ! errors.empty())
+	{
+		_Success = false;
+		printf(_("Statement::ExecuteBatch() returned unexpected counts.\n"));
+	}
+
+	// A prepared statement, run again under another transaction
+	st1->Prepare("select N2, N6 from test");
+	st1->Execute();
+	tr1->Commit();
+	IBPP::Transaction tr2 = IBPP::TransactionFactory(db1);
+	tr2->Start();
+	st1->AttachTransaction(tr2);
+	st1->Execute();
+	int32_t again = 0;
+	while (st1->Fetch())
+		++again;
+	if (again != total)
+	{
+		_Success = false;
+		printf(_("Statement::AttachTransaction() : read %d rows instead of %d.\n"),
+			again, total);
+	}
+	tr2->Commit();
+
+	// But not under a transaction of another attachment
+	IBPP::Database db2 = IBPP::DatabaseFactory(ServerName, DbName, UserName, Password);
+	db2->Connect();
+	IBPP::Transaction tr3 = IBPP::TransactionFactory(db2, IBPP::amRead);
+	try
+	{
+		st1->AttachTransaction(tr3);
+		_Success = false;
+		printf(_("Statement::AttachTransaction() accepted a transaction of another database.\n"));
+	}
+	catch (IBPP::LogicException&) { }
+	tr3.clear();
+	db2->Disconnect();
+
+	// A batch in which one row divides by zero, the others are inserted
+	st1->AttachTransaction(tr1);
+	tr1->Start();
+	st1->Prepare("insert into BULK(ID, NAME) values(1000 / ?, ?)");
+	for (int32_t n = 1; n <= 40; n++)
+	{
+		st1->Set(1, n == 17 ? 0 : n);
+		st1->Set(2, "split");
+		st1->AddBatch();
+	}
+	st1->ExecuteBatch(affected, errors);
+	tr1->Commit();
+	if (errors.size() != 1 || errors[0].row != 16 || affected[16] != -1
+		|| affected[15] != 1 || affected[39] != 1)
+	{
+		_Success = false;
+		printf(_("Statement::ExecuteBatch() did not isolate the failing row.\n"));
+	}
+
+	// Non-ASCII text (WIN1252) is stored the same by a block as by a single row
+	const std::string accented = "Caf\xE9 cr\xE8me \xE0 l'\xE9t\xE9";
+	tr1->Start();
+	st1->Prepare("insert into BULK(ID, NAME) values(?, ?)");
+	for (int32_t n = 2000; n < 2008; n++)
+	{
+		st1->Set(1, n);
+		st1->Set(2, accented);
+		st1->AddBatch();
+	}
+	st1->Set(1, 2008);
+	st1->Set(2, accented);
+	st1->ExecuteBatch(affected, errors);
+	st1->Execute();		// The parameters Set() before are still there
+	std::string name;
+	int32_t same = 0;
+	st1->Prepare("select NAME from BULK where ID between 2000 and 2008");
+	st1->Execute();
+	while (st1->Fetch())
+	{
+		st1->Get(1, name);
+		if (name == accented) ++same;
+	}
+	tr1->Commit();
+	if (! errors.empty() || same != 9)
+	{
+		_Success = false;
+		printf(_("Statement::ExecuteBatch() stored %d of 9 non-ASCII strings unchanged.\n"),
+			same);
+	}
+
+	// A lock conflict between two no wait transactions, returned not thrown
+	tr1->Start();
+	st1->ExecuteImmediate("insert into BULK(ID, NAME) values(1, 'conflict')");
+	tr1->Commit();
+	IBPP::Transaction tr7 = IBPP::TransactionFactory(db1, IBPP::amWrite,
+		IBPP::ilConcurrency, IBPP::lrNoWait);
+	IBPP::Transaction tr8 = IBPP::TransactionFactory(db1, IBPP::amWrite,
+		IBPP::ilConcurrency, IBPP::lrNoWait);
+	tr7->Start();
+	tr8->Start();
+	IBPP::Statement st9 = IBPP::StatementFactory(db1, tr7,
+		"update BULK set NAME = 'first' where ID = 1");
+	IBPP::Statement st10 = IBPP::StatementFactory(db1, tr8,
+		"update BULK set NAME = 'second' where ID = 1");
+	IBPP::Status first = st9->TryExecute();
+	IBPP::Status second = st10->TryExecute();
+	tr8->Rollback();
+	if (! first.Ok() || second.Ok() || second.EngineCode() == 0 || ! tr7->TryCommit().Ok())
+	{
+		_Success = false;
+		printf(_("Statement::TryExecute() did not report the lock conflict.\n"));
+	}
+
+	// The same conflict, run again by Retry() once the other transaction is gone
+	tr8->Start();
+	st10->Execute();
+	int tries = 0;
+	int runs = IBPP::Retry(tr7, [&]()
+	{
+		if (++tries == 2) tr8->Rollback();
+		st9->Execute();
+	});
+	int64_t conflicts;
+	IBPP::RetryStatistics(0, &conflicts, 0, 0);
+	if (runs != 2 || conflicts < 1)
+	{
+		_Success = false;
+		printf(_("IBPP::Retry() : %d runs, %d conflicts instead of 2 and 1.\n"),
+			runs, (int)conflicts);
+	}
+
+	// A wait for a lock which gives up after a second
+	IBPP::Transaction tr9 = IBPP::TransactionFactory(db1, IBPP::amWrite,
+		IBPP::ilConcurrency, IBPP::lrWait, IBPP::TFF(0), 1);
+	tr8->Start();
+	st10->Execute();
+	tr9->Start();
+	IBPP::Statement st11 = IBPP::StatementFactory(db1, tr9,
+		"update BULK set NAME = 'third' where ID = 1");
+	IBPP::Status timedout = st11->TryExecute();
+	tr9->Rollback();
+	tr8->Rollback();
+	if (timedout.Ok())
+	{
+		_Success = false;
+		printf(_("Transaction : the lock timeout did not end the wait.\n"));
+	}
+}
+
+void Test::Test10()
+{
+	printf(_("Test 10 --- Pool, executor, prefetch, parallel scan and bulk loader\n"));
+
+	IBPP::Database db1;
+	db1 = IBPP::DatabaseFactory(ServerName, DbName, UserName, Password);
+	db1->Connect();
+
+	IBPP::Transaction tr1 = IBPP::TransactionFactory(db1, IBPP::amRead);
+	tr1->Start();
+	IBPP::Statement st1 = IBPP::StatementFactory(db1, tr1);
+	int32_t total = 0;
+	st1->Execute("select count(*) from test");
+	if (st1->Fetch()) st1->Get(1, total);
+	tr1->Commit();
+
+	// A pool of two attachments, on which the count is already prepared
+	int hits, misses;
+	std::vector<std::string> warm(1, "select count(*) from test");
+	IBPP::DatabasePool pool = IBPP::DatabasePoolFactory(ServerName, DbName,
+		UserName, Password, "", "", 2, 2, 0, warm);
+	IBPP::Database db2 = pool->Acquire();
+	IBPP::Transaction tr2 = IBPP::TransactionFactory(db2, IBPP::amRead);
+	tr2->Start();
+	{
+		IBPP::Statement st2 = IBPP::StatementFactory(db2, tr2, "select count(*) from test");
+	}
+	tr2->Commit();
+	tr2.clear();
+	db2->StatementCacheStatistics(&hits, &misses, 0);
+	if (hits != 1 || misses != 1)
+	{
+		_Success = false;
+		printf(_("DatabasePool : %d hits and %d misses on the warm statement instead of 1 and 1.\n"),
+			hits, misses);
+	}
+	int open, idle;
+	pool->Return(db2);
+	pool->Sizes(&open, &idle);
+	if (db2 != 0 || open != 2 || idle != 2)
+	{
+		_Success = false;
+		printf(_("DatabasePool : %d attachments open, %d idle instead of 2 and 2.\n"),
+			open, idle);
+	}
+	try
+	{
+		pool->Return(db1);		// Not one of the pool
+		_Success = false;
+		printf(_("DatabasePool::Return() accepted a foreign Database.\n"));
+	}
+	catch (IBPP::LogicException&) { }
+
+	// The same count, run by an executor thread
+	IBPP::Executor ex = IBPP::ExecutorFactory(db1);
+	IBPP::Transaction tr4 = IBPP::TransactionFactory(db1, IBPP::amRead);
+	tr4->Start();
+	IBPP::Statement st4 = IBPP::StatementFactory(db1, tr4);
+	ex->ExecuteAsync(st4, "select count(*) from test").get();
+	IBPP::Row counted = ex->FetchAsync(st4).get();
+	if (counted == 0 || ex->FetchAsync(st4).get() != 0)
+	{
+		_Success = false;
+		printf(_("Executor::FetchAsync() did not return one row.\n"));
+	}
+	ex->CommitAsync(tr4).get();
+	ex.clear();
+
+	// The whole table, prefetched through a small ring
+	IBPP::Transaction tr5 = IBPP::TransactionFactory(db1, IBPP::amRead);
+	tr5->Start();
+	IBPP::Statement st5 = IBPP::StatementFactory(db1, tr5, "select N2, N6 from test");
+	st5->Execute();
+	st5->Prefetch(8);
+	IBPP::Row prefetched;
+	int32_t count = 0;
+	while (st5->Fetch(prefetched))
+		++count;
+	int ahead, stalls, waits;
+	st5->PrefetchStatistics(&ahead, &stalls, &waits);
+	if (count != total || ahead != total || stalls > count + 1 || waits > count)
+	{
+		_Success = false;
+		printf(_("Statement::Prefetch() : read %d rows, %d ahead instead of %d.\n"),
+			count, ahead, total);
+	}
+	tr5->Commit();
+
+	// The whole table again, by three ranges of ID read in order
+	IBPP::ParallelScan scan = IBPP::ParallelScanFactory(db1,
+		"select ID, N2 from test", "ID", 3, IBPP::psByKey);
+	int32_t id, previd = -1;
+	count = 0;
+	bool detached = true;
+	while (scan->Fetch(prefetched))
+	{
+		prefetched->Get(1, id);
+		if (id <= previd) break;
+		if (prefetched->DatabasePtr() != 0) detached = false;
+		previd = id;
+		++count;
+	}
+	if (scan->Fetch(prefetched))	// Still the end, once more
+	{
+		_Success = false;
+		printf(_("ParallelScan::Fetch() returned a row after the end of the scan.\n"));
+	}
+	if (count != total || ! detached)
+	{
+		_Success = false;
+		printf(_("ParallelScan : read %d rows in order instead of %d, %s.\n"),
+			count, total, detached ? "detached" : "still attached to their range");
+	}
+	try
+	{
+		IBPP::ParallelScanFactory(db1, "select ID from test", "ID) or (1=1", 2);
+		_Success = false;
+		printf(_("ParallelScan accepted a key which is not a column name.\n"));
+	}
+	catch (IBPP::LogicException&) { }
+
+	// Rows loaded through two attachments, committing every 100 rows
+	IBPP::BulkLoader loader = IBPP::BulkLoaderFactory(db1,
+		"insert into BULK(ID, NAME) values(?, ?)", 2, 100);
+	IBPP::Row bulk = loader->NewRow();
+	for (int32_t n = 0; n < 1000; n++)
+	{
+		bulk->Set(1, n);
+		bulk->Set(2, "bulk");
+		loader->Add(bulk);
+	}
+	loader->Close();
+	IBPP::BulkLoaderStats loaded;
+	loader->Statistics(loaded);
+	int32_t bulkcount = 0;
+	tr1->Start();
+	st1->Execute("select count(*) from BULK where NAME = 'bulk'");
+	if (st1->Fetch()) st1->Get(1, bulkcount);
+	tr1->Commit();
+	if (loaded.loaded != 1000 || bulkcount != 1000 || loaded.failed != 0
+		|| loaded.commits < 1000 / 100)
+	{
+		_Success = false;
+		printf(_("BulkLoader : %d rows loaded, %d counted, %d commits instead of 1000, 1000 and 10 or more.\n"),
+			(int)loaded.loaded, bulkcount, (int)loaded.commits);
+	}
+}
+
+void Test::Test11()
+{
+	printf(_("Test 11 --- Tracing, query statistics, performance counters and plans\n"));
+
+	IBPP::Database db1;
+	db1 = IBPP::DatabaseFactory(ServerName, DbName, UserName, Password);
+	db1->Connect();
+
+	IBPP::Transaction tr1 = IBPP::TransactionFactory(db1);
+	IBPP::Statement st1 = IBPP::StatementFactory(db1, tr1);
+
+	// The calls of the client library, seen by an observer
+	struct Tracer : public IBPP::ITraceObserver
+	{
+		int before, after, fetches;
+		void Before(const IBPP::TraceEvent&) { ++before; }
+		void After(const IBPP::TraceEvent& event)
+			{ ++after; if (event.op == IBPP::toFetch && event.sql != 0) ++fetches; }
+		Tracer() : before(0), after(0), fetches(0) { }
+	} tracer;
+	IBPP::SetTraceObserver(&tracer);
+	tr1->Start();
+	st1->Execute("select count(*) from BULK");
+	st1->Fetch();
+	tr1->Commit();
+	IBPP::SetTraceObserver(0);
+	if (tracer.before == 0 || tracer.before != tracer.after || tracer.fetches != 1)
+	{
+		_Success = false;
+		printf(_("IBPP::SetTraceObserver() : %d calls before, %d after, %d fetches.\n"),
+			tracer.before, tracer.after, tracer.fetches);
+	}
+
+	// Latency and rows by SQL fingerprint
+	IBPP::ResetQueryStats();
+	IBPP::EnableQueryStats(true);
+	tr1->Start();
+	st1->Execute("select count(*) from BULK where ID > 10");
+	st1->Fetch();
+	st1->Execute("SELECT COUNT(*)\n  FROM BULK WHERE ID>20 -- again");
+	st1->Fetch();
+	tr1->Commit();
+	IBPP::EnableQueryStats(false);
+	std::vector<IBPP::QueryStats> queries;
+	IBPP::QueryStatsSnapshot(queries);
+	const std::string fingerprint = IBPP::QueryFingerprint("select count(*) from BULK where ID > 0");
+	size_t q;
+	for (q = 0; q < queries.size() && queries[q].fingerprint != fingerprint; q++) ;
+	if (q == queries.size() || queries[q].execute.count != 2
+		|| queries[q].rowsFetched != 2 || queries[q].fetch.count != 2
+		|| IBPP::QueryStatsJson(queries).find(fingerprint) == std::string::npos)
+	{
+		_Success = false;
+		printf(_("IBPP::QueryStatsSnapshot() : '%s' not counted as expected.\n"),
+			fingerprint.c_str());
+	}
+	if (IBPP::QueryFingerprint("select first 10 ID from BULK where ID between 1 and 5")
+			!= IBPP::QueryFingerprint("SELECT FIRST 3 ID FROM bulk WHERE id BETWEEN -2 AND 7")
+		|| IBPP::QueryFingerprint("select ID - 1 from BULK")
+			== IBPP::QueryFingerprint("select ID from BULK"))
+	{
+		_Success = false;
+		printf(_("IBPP::QueryFingerprint() kept a literal or dropped an operator.\n"));
+	}
+
+	// Counters of the relations, before and after some inserts
+	IBPP::DatabaseStats before, after;
+	db1->Statistics(before);
+	tr1->Start();
+	st1->Prepare("insert into BULK(ID, NAME) values(?, 'delta')");
+	for (int i = 0; i < 7; i++)
+	{
+		st1->Set(1, 5000 + i);
+		st1->Execute();
+	}
+	tr1->Commit();
+	db1->Statistics(after);
+	IBPP::DatabaseStats delta = after - before;
+	std::map<int, IBPP::RelationStats>::const_iterator rel;
+	for (rel = delta.relations.begin(); rel != delta.relations.end()
+		&& rel->second.name != "BULK"; ++rel) ;
+	if (rel == delta.relations.end() || rel->second.inserts != 7
+		|| after.pageSize == 0 || delta.fetches <= 0)
+	{
+		_Success = false;
+		printf(_("Database::Statistics(DatabaseStats&) : 7 inserts not seen on BULK.\n"));
+	}
+
+	// SET STATS : the cost of a select, from its execution to its last row
+	IBPP::PerfStats perf;
+	st1->SetPerfStats(true);
+	tr1->SetPerfStats(true);
+	tr1->Start();
+	st1->Execute("select ID, NAME from BULK order by NAME");
+	int perfRows = 0;
+	while (st1->Fetch()) perfRows++;
+	st1->PerfStatistics(perf);
+	tr1->Commit();
+	st1->SetPerfStats(false);
+	tr1->SetPerfStats(false);
+	if (perfRows == 0 || perf.fetches <= 0 || perf.pageSize == 0 || perf.elapsedMs < 0)
+	{
+		_Success = false;
+		printf(_("Statement::PerfStatistics() : %d fetches, page size %d.\n"),
+			(int)perf.fetches, perf.pageSize);
+	}
+	tr1->PerfStatistics(perf);
+	if (perf.pageSize == 0)
+	{
+		_Success = false;
+		printf(_("Transaction::PerfStatistics() : the commit was not measured.\n"));
+	}
+
+	// Plans as trees, and the natural scans flagged at Prepare() time
+	std::vector<IBPP::PlanNode> plans;
+	IBPP::ParsePlan("PLAN SORT (JOIN (A NATURAL, B INDEX (PK_B, IX_B)))", plans);
+	if (plans.size() != 1 || plans[0].children.size() != 1
+		|| plans[0].children[0].type != IBPP::pnSort
+		|| plans[0].children[0].children[0].children.size() != 2
+		|| plans[0].children[0].children[0].children[1].indexes.size() != 2)
+	{
+		_Success = false;
+		printf(_("IBPP::ParsePlan() : unexpected tree.\n"));
+	}
+
+	std::vector<IBPP::PlanAlert> planAlerts;
+	IBPP::PlanPolicy policy;
+	policy.naturalRows = 0;		// Every natural scan
+	policy.alert = [&planAlerts](const IBPP::PlanAlert& alert) { planAlerts.push_back(alert); };
+	IBPP::SetPlanPolicy(policy);
+	tr1->Start();
+	st1->Prepare("select NAME from BULK where NAME = 'plan'");
+	st1->Plan(plans);
+	tr1->Commit();
+	std::map<std::string, std::string> captured;
+	IBPP::PlanCapture(captured);
+	IBPP::ClearPlanPolicy();
+	if (planAlerts.size() != 1 || planAlerts[0].kind != IBPP::paNaturalScan
+		|| planAlerts[0].relation != "BULK" || captured.size() != 1
+		|| plans.size() != 1 || plans[0].children[0].type != IBPP::pnNatural)
+	{
+		_Success = false;
+		printf(_("IBPP::SetPlanPolicy() : %d alerts, %d plans captured.\n"),
+			(int)planAlerts.size(), (int)captured.size());
+	}
 
+	// The last test drops the database
 	db1->Drop();
 }
 